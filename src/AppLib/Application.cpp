@@ -15,9 +15,9 @@ Application::~Application()
 }
 
 
-bool Application::Initialize(const char* title, int width, int height)
+bool Application::Initialize(const char* title, int width, int height, bool offscreen)
 {
-	if (!m_window.Initialize(title, width, height))
+	if (!m_window.Initialize(title, width, height, offscreen))
 		return false;
 
 	OnInitialize();
@@ -57,8 +57,9 @@ void Application::Run()
 		//Update(m_frameTime);
 		//frames++;
 
-		// Update and render 60 times per second.
-		if (newTime >= renderTime + frameTime)
+		// Update and render 60 times per second. Offscreen windows aren't
+		// shown, so they run as fast as they can.
+		if (m_window.IsOffscreen() || newTime >= renderTime + frameTime)
 		{
 			Update(m_frameTime);
 			frames++;
@@ -16,7 +16,7 @@ public:
 	Application();
 	virtual ~Application();
 
-	bool Initialize(const char* title, int width, int height);
+	bool Initialize(const char* title, int width, int height, bool offscreen = false);
 	void Run();
 	void Update(float timeDelta);
 	void Render();
@@ -8,13 +8,22 @@ Window::Window()
 	: m_sdlWindow(NULL)
 	, m_width(0)
 	, m_height(0)
+	, m_isOffscreen(false)
+	, m_framebuffer(0)
 {
+	m_renderbuffers[0] = 0;
+	m_renderbuffers[1] = 0;
 }
 
 Window::~Window()
 {
 	if (m_sdlWindow != NULL)
 	{
+		if (m_framebuffer != 0)
+		{
+			glDeleteFramebuffers(1, &m_framebuffer);
+			glDeleteRenderbuffers(2, m_renderbuffers);
+		}
 		SDL_GL_DeleteContext(m_glContext);
 		SDL_DestroyWindow(m_sdlWindow);
 	}
@@ -25,9 +34,13 @@ void Window::SetTitle(const char* title)
 	SDL_SetWindowTitle(m_sdlWindow, title);
 }
 
-bool Window::Initialize(const char* title, int width, int height)
+bool Window::Initialize(const char* title, int width, int height, bool offscreen)
 {
-	SDL_Init(SDL_INIT_EVERYTHING);
+	if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+	{
+		fprintf(stderr, "SDL init error: '%s'\n", SDL_GetError());
+		return false;
+	}
 
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE,     8);
 	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE,   8);
@@ -40,13 +53,28 @@ bool Window::Initialize(const char* title, int width, int height)
 	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
 	SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
 	
+	Uint32 flags = SDL_WINDOW_OPENGL;
+	if (offscreen)
+		flags |= SDL_WINDOW_HIDDEN;
+	else
+		flags |= SDL_WINDOW_RESIZABLE;
+
 	m_sdlWindow = SDL_CreateWindow(title,
 								   SDL_WINDOWPOS_CENTERED,
 								   SDL_WINDOWPOS_CENTERED,
-								   width, height,
-								   SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+								   width, height, flags);
+	if (m_sdlWindow == NULL)
+	{
+		fprintf(stderr, "Window creation error: '%s'\n", SDL_GetError());
+		return false;
+	}
 	
 	m_glContext = SDL_GL_CreateContext(m_sdlWindow);
+	if (m_glContext == NULL)
+	{
+		fprintf(stderr, "OpenGL context creation error: '%s'\n", SDL_GetError());
+		return false;
+	}
 	
 	//SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
 	//SDL_GL_SetSwapInterval(1); // VSync
@@ -65,6 +93,35 @@ bool Window::Initialize(const char* title, int width, int height)
 	m_width  = width;
 	m_height = height;
 
+	// Render offscreen windows into a framebuffer object, which stays bound
+	// in place of the window's own framebuffer.
+	m_isOffscreen = offscreen;
+	if (m_isOffscreen)
+	{
+		if (!GLEW_VERSION_3_0)
+		{
+			fprintf(stderr, "Offscreen rendering requires OpenGL 3.0\n");
+			return false;
+		}
+
+		glGenRenderbuffers(2, m_renderbuffers);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGenFramebuffers(1, &m_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			fprintf(stderr, "Offscreen framebuffer is incomplete\n");
+			return false;
+		}
+	}
+
 	// Setup OpenGL.
 
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -93,12 +150,20 @@ bool Window::Initialize(const char* title, int width, int height)
 
 void Window::SwapWindow()
 {
-	SDL_GL_SwapWindow(m_sdlWindow);
+	// There is nothing to show for an offscreen window.
+	if (m_isOffscreen)
+		glFlush();
+	else
+		SDL_GL_SwapWindow(m_sdlWindow);
 }
 
 
 void Window::OnResize()
 {
+	// Offscreen windows keep the size of their framebuffer.
+	if (m_isOffscreen)
+		return;
+
 	SDL_GetWindowSize(m_sdlWindow, &m_width, &m_height);
 	glViewport(0, 0, m_width, m_height);
 	glMatrixMode(GL_PROJECTION);
@@ -14,7 +14,10 @@ public:
 	Window();
 	~Window();
 	
-	bool Initialize(const char* title, int width, int height);
+	// An offscreen window is never shown. Everything is rendered into a
+	// framebuffer object the size of the window instead. It is still a
+	// hidden SDL window with a GL context, so it needs a display server.
+	bool Initialize(const char* title, int width, int height, bool offscreen = false);
 
 	void SetTitle(const char* title);
 
@@ -25,12 +28,17 @@ public:
 	inline int GetWidth() const { return m_width; }
 	inline int GetHeight() const { return m_height; }
 	inline float GetAspectRatio() const { return ((float) m_width / (float) m_height); }
+	inline bool IsOffscreen() const { return m_isOffscreen; }
 
 private:
 	SDL_Window* m_sdlWindow;
 	SDL_GLContext m_glContext;
 	int m_width;
 	int m_height;
+
+	bool m_isOffscreen;
+	unsigned int m_framebuffer;
+	unsigned int m_renderbuffers[2]; // Color and depth.
 };
 
 
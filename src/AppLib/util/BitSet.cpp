@@ -0,0 +1,99 @@
+#include "BitSet.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Index of the lowest set bit (the word must be non-zero).
+static inline int LowestBit(unsigned int word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, word);
+	return (int) index;
+#else
+	return __builtin_ctz(word);
+#endif
+}
+
+// Index of the highest set bit (the word must be non-zero).
+static inline int HighestBit(unsigned int word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, word);
+	return (int) index;
+#else
+	return 31 - __builtin_clz(word);
+#endif
+}
+
+
+BitSet::BitSet()
+	: m_size(0)
+{
+}
+
+BitSet::BitSet(int size)
+	: m_size(0)
+{
+	Resize(size);
+}
+
+void BitSet::Resize(int size)
+{
+	m_size = size;
+	m_words.assign((size + 31) >> 5, 0u);
+}
+
+void BitSet::ClearAll()
+{
+	m_words.assign(m_words.size(), 0u);
+}
+
+int BitSet::FindNextUnset(int index) const
+{
+	if (index < 0)
+		index = 0;
+	if (index >= m_size)
+		return -1;
+
+	int wordIndex = index >> 5;
+	int numWords = (int) m_words.size();
+
+	// Mask off the bits before the index in the first word.
+	unsigned int unset = ~m_words[wordIndex] & (0xFFFFFFFFu << (index & 31));
+
+	while (unset == 0)
+	{
+		if (++wordIndex >= numWords)
+			return -1;
+		unset = ~m_words[wordIndex];
+	}
+
+	index = (wordIndex << 5) + LowestBit(unset);
+	return (index < m_size ? index : -1);
+}
+
+int BitSet::FindPrevUnset(int index) const
+{
+	if (index >= m_size)
+		index = m_size - 1;
+	if (index < 0)
+		return -1;
+
+	int wordIndex = index >> 5;
+
+	// Mask off the bits after the index in the first word.
+	unsigned int unset = ~m_words[wordIndex] & (0xFFFFFFFFu >> (31 - (index & 31)));
+
+	while (unset == 0)
+	{
+		if (--wordIndex < 0)
+			return -1;
+		unset = ~m_words[wordIndex];
+	}
+
+	return (wordIndex << 5) + HighestBit(unset);
+}
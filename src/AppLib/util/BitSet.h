@@ -0,0 +1,52 @@
+#ifndef _BIT_SET_H_
+#define _BIT_SET_H_
+
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// BitSet - a fixed size set of bits packed into 32-bit words, which can
+// quickly find the nearest set or unset bit in either direction.
+//-----------------------------------------------------------------------------
+class BitSet
+{
+public:
+	BitSet();
+	BitSet(int size);
+
+	// Resize the set and clear all bits. Memory is reused when shrinking.
+	void Resize(int size);
+	void ClearAll();
+
+	int GetSize() const { return m_size; }
+
+	inline bool Get(int index) const
+	{
+		return ((m_words[index >> 5] >> (index & 31)) & 1) != 0;
+	}
+
+	inline void Set(int index)
+	{
+		m_words[index >> 5] |= (1u << (index & 31));
+	}
+
+	inline void Clear(int index)
+	{
+		m_words[index >> 5] &= ~(1u << (index & 31));
+	}
+
+	// Find the first unset bit at or after the given index. Returns -1 if
+	// there are none.
+	int FindNextUnset(int index) const;
+
+	// Find the last unset bit at or before the given index. Returns -1 if
+	// there are none.
+	int FindPrevUnset(int index) const;
+
+private:
+	int							m_size;
+	std::vector<unsigned int>	m_words;
+};
+
+
+#endif // _BIT_SET_H_
@@ -0,0 +1,252 @@
+#include "JobSystem.h"
+#include "Timing.h"
+
+
+//-----------------------------------------------------------------------------
+// TaskGroup
+//-----------------------------------------------------------------------------
+
+TaskGroup::TaskGroup()
+	: m_numPending(0)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// JobSystem
+//-----------------------------------------------------------------------------
+
+JobSystem::JobSystem(int numWorkers)
+	: m_numQueuedJobs(0)
+	, m_isShuttingDown(false)
+{
+	if (numWorkers <= 0)
+		numWorkers = (int) std::thread::hardware_concurrency();
+	if (numWorkers <= 0)
+		numWorkers = 1;
+
+	m_utilizationStartTime = Time::GetTime();
+
+	// Create all the workers before starting their threads, as the threads
+	// look at each other's deques.
+	for (int i = 0; i < numWorkers; i++)
+	{
+		Worker* worker = new Worker();
+		worker->busyTime = 0.0;
+		m_workers.push_back(worker);
+	}
+
+	// Worker 0 is the calling thread.
+	m_workers[0]->threadId = std::this_thread::get_id();
+	for (int i = 1; i < numWorkers; i++)
+	{
+		m_workers[i]->thread = std::thread(&JobSystem::WorkerThread, this, i);
+		m_workers[i]->threadId = m_workers[i]->thread.get_id();
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_isShuttingDown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		if (m_workers[i]->thread.joinable())
+			m_workers[i]->thread.join();
+		delete m_workers[i];
+	}
+	m_workers.clear();
+}
+
+void JobSystem::SetMainThread()
+{
+	m_workers[0]->threadId = std::this_thread::get_id();
+}
+
+void JobSystem::Run(TaskGroup& group, const std::function<void()>& func, TaskGroup* dependency)
+{
+	Job* job = new Job();
+	job->func = func;
+	job->group = &group;
+	group.m_numPending++;
+
+	if (dependency != NULL)
+	{
+		// Leave the job with the dependency if it hasn't finished yet. It will
+		// be scheduled when the dependency's last job finishes.
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+		if (dependency->m_numPending > 0)
+		{
+			dependency->m_continuations.push_back(job);
+			return;
+		}
+	}
+
+	Schedule(job);
+}
+
+void JobSystem::Wait(TaskGroup& group)
+{
+	int worker = GetCurrentWorker();
+
+	while (!group.IsDone())
+	{
+		if (!RunOneJob(worker))
+			std::this_thread::yield();
+	}
+
+	// Make sure the thread that finished the last job is done with the group
+	// before the caller can destroy it.
+	std::lock_guard<std::mutex> lock(group.m_mutex);
+}
+
+float JobSystem::GetWorkerUtilization(int worker) const
+{
+	double startTime;
+	{
+		std::lock_guard<std::mutex> lock(m_utilizationMutex);
+		startTime = m_utilizationStartTime;
+	}
+	double elapsed = Time::GetTime() - startTime;
+	if (elapsed <= 0.0)
+		return 0.0f;
+	std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+	return (float) (m_workers[worker]->busyTime / elapsed);
+}
+
+void JobSystem::ResetUtilization()
+{
+	std::lock_guard<std::mutex> utilizationLock(m_utilizationMutex);
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		std::lock_guard<std::mutex> lock(m_workers[i]->mutex);
+		m_workers[i]->busyTime = 0.0;
+	}
+	m_utilizationStartTime = Time::GetTime();
+}
+
+void JobSystem::WorkerThread(int index)
+{
+	while (true)
+	{
+		if (RunOneJob(index))
+			continue;
+
+		// Sleep until there is more work.
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]()
+		{
+			return (m_numQueuedJobs > 0 || m_isShuttingDown);
+		});
+		if (m_isShuttingDown)
+			return;
+	}
+}
+
+// Find the calling thread's worker, or -1 if it isn't a worker.
+int JobSystem::GetCurrentWorker() const
+{
+	std::thread::id id = std::this_thread::get_id();
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		if (m_workers[i]->threadId == id)
+			return (int) i;
+	}
+	return -1;
+}
+
+void JobSystem::Schedule(Job* job)
+{
+	// Threads which aren't workers share worker 0's deque.
+	int index = GetCurrentWorker();
+	Worker* worker = m_workers[index >= 0 ? index : 0];
+	{
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		worker->jobs.push_back(job);
+	}
+
+	// Take the wake lock, so a worker can't miss the notification between
+	// checking the job count and going to sleep.
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_numQueuedJobs++;
+	}
+	m_wakeCondition.notify_one();
+}
+
+bool JobSystem::RunOneJob(int worker)
+{
+	Job* job = TakeJob(worker >= 0 ? worker : 0);
+	if (job == NULL)
+		return false;
+
+	double startTime = Time::GetTime();
+	job->func();
+
+	// Only count the time of the workers themselves, as several threads
+	// which aren't workers could be running jobs at once.
+	if (worker >= 0)
+	{
+		double busyTime = Time::GetTime() - startTime;
+		std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+		m_workers[worker]->busyTime += busyTime;
+	}
+
+	FinishJob(job);
+	return true;
+}
+
+// Take the newest job from the worker's own deque, or else steal the oldest
+// job from another worker.
+Job* JobSystem::TakeJob(int worker)
+{
+	if (m_numQueuedJobs == 0)
+		return NULL;
+
+	int numWorkers = (int) m_workers.size();
+	for (int i = 0; i < numWorkers; i++)
+	{
+		Worker* victim = m_workers[(worker + i) % numWorkers];
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (victim->jobs.empty())
+			continue;
+
+		Job* job;
+		if (i == 0)
+		{
+			job = victim->jobs.back();
+			victim->jobs.pop_back();
+		}
+		else
+		{
+			job = victim->jobs.front();
+			victim->jobs.pop_front();
+		}
+		m_numQueuedJobs--;
+		return job;
+	}
+
+	return NULL;
+}
+
+void JobSystem::FinishJob(Job* job)
+{
+	TaskGroup* group = job->group;
+	delete job;
+
+	// Schedule the jobs that were waiting for the group to finish. The group
+	// must not be touched after its lock is released, as a waiting thread may
+	// destroy it.
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(group->m_mutex);
+		if (--group->m_numPending == 0)
+			continuations.swap(group->m_continuations);
+	}
+	for (unsigned int i = 0; i < continuations.size(); i++)
+		Schedule(continuations[i]);
+}
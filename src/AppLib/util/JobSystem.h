@@ -0,0 +1,178 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class JobSystem;
+struct Job;
+
+
+//-----------------------------------------------------------------------------
+// TaskGroup - a set of jobs which can be waited on together. Jobs can be made
+// to wait for another group to finish before they start.
+//-----------------------------------------------------------------------------
+class TaskGroup
+{
+public:
+	TaskGroup();
+
+	// A group is done when all of its jobs have finished.
+	bool IsDone() const { return (m_numPending == 0); }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int>	m_numPending;
+	std::mutex			m_mutex;
+	std::vector<Job*>	m_continuations; // Jobs waiting for this group to finish.
+
+	TaskGroup(const TaskGroup&);
+	TaskGroup& operator =(const TaskGroup&);
+};
+
+
+struct Job
+{
+	std::function<void()>	func;
+	TaskGroup*				group;
+};
+
+
+//-----------------------------------------------------------------------------
+// JobSystem - a pool of worker threads which run jobs. Each worker has its
+// own deque of jobs: it takes the newest job from its own deque, and when
+// that is empty, it steals the oldest job from another worker. The thread
+// which created the job system counts as worker 0, unless another thread
+// takes its place with SetMainThread. Any thread runs jobs
+// while it waits for a group to finish, but threads which aren't workers
+// share worker 0's deque and their time isn't counted in the utilization.
+//-----------------------------------------------------------------------------
+class JobSystem
+{
+public:
+	// A worker count of 0 uses one worker per hardware thread.
+	JobSystem(int numWorkers = 0);
+	~JobSystem();
+
+	int GetNumWorkers() const { return (int) m_workers.size(); }
+
+	// Make the calling thread worker 0, in place of the thread which created
+	// the job system. This must be called before the thread runs any jobs,
+	// while no other thread is using the job system.
+	void SetMainThread();
+
+	// Add a job to a group. If a dependency is given, the job will not start
+	// until the dependency group has finished.
+	void Run(TaskGroup& group, const std::function<void()>& func, TaskGroup* dependency = NULL);
+
+	// Run jobs until the group has finished.
+	void Wait(TaskGroup& group);
+
+	// Call func(i) for every i in [0, count), split into jobs of up to
+	// grainSize indices, and wait for them all to finish.
+	template <class T_Func>
+	void ParallelFor(int count, const T_Func& func, int grainSize = 1);
+
+	// Reduce the values mapped from each index in [0, count). The indices are
+	// split into fixed chunks of grainSize, each chunk is reduced on its own
+	// starting from the identity value, then the chunk results are reduced
+	// in order. The result does not depend on the number of workers or the
+	// order the jobs ran in.
+	template <class T_Value, class T_Map, class T_Reduce>
+	T_Value ParallelReduce(int count, const T_Value& identity,
+						   const T_Map& map, const T_Reduce& reduce, int grainSize = 64);
+
+	// The fraction of time each worker has spent running jobs since the
+	// utilization was last reset. These can be called from any thread.
+	float GetWorkerUtilization(int worker) const;
+	void ResetUtilization();
+
+private:
+	struct Worker
+	{
+		std::thread			thread;
+		std::thread::id		threadId;
+		std::mutex			mutex;		// Guards the jobs and the busy time.
+		std::deque<Job*>	jobs;
+		double				busyTime;
+	};
+
+	void WorkerThread(int index);
+	int GetCurrentWorker() const; // -1 if the calling thread isn't a worker.
+	void Schedule(Job* job);
+	bool RunOneJob(int worker);
+	Job* TakeJob(int worker);
+	void FinishJob(Job* job);
+
+	std::vector<Worker*>	m_workers;
+	std::atomic<int>		m_numQueuedJobs;
+	std::mutex				m_wakeMutex;
+	std::condition_variable	m_wakeCondition;
+	bool					m_isShuttingDown;
+	mutable std::mutex		m_utilizationMutex; // Guards the utilization start time.
+	double					m_utilizationStartTime;
+};
+
+
+template <class T_Func>
+void JobSystem::ParallelFor(int count, const T_Func& func, int grainSize)
+{
+	if (count <= 0)
+		return;
+	if (grainSize < 1)
+		grainSize = 1;
+
+	// Run small loops on the calling thread.
+	if (count <= grainSize || m_workers.size() <= 1)
+	{
+		for (int i = 0; i < count; i++)
+			func(i);
+		return;
+	}
+
+	TaskGroup group;
+	for (int begin = 0; begin < count; begin += grainSize)
+	{
+		int end = (begin + grainSize < count ? begin + grainSize : count);
+		Run(group, [&func, begin, end]()
+		{
+			for (int i = begin; i < end; i++)
+				func(i);
+		});
+	}
+	Wait(group);
+}
+
+template <class T_Value, class T_Map, class T_Reduce>
+T_Value JobSystem::ParallelReduce(int count, const T_Value& identity,
+								  const T_Map& map, const T_Reduce& reduce, int grainSize)
+{
+	if (grainSize < 1)
+		grainSize = 1;
+	int numChunks = (count + grainSize - 1) / grainSize;
+
+	std::vector<T_Value> results(numChunks, identity);
+	ParallelFor(numChunks, [&](int chunk)
+	{
+		int begin = chunk * grainSize;
+		int end = (begin + grainSize < count ? begin + grainSize : count);
+		T_Value value = identity;
+		for (int i = begin; i < end; i++)
+			value = reduce(value, map(i));
+		results[chunk] = value;
+	});
+
+	T_Value value = identity;
+	for (int i = 0; i < numChunks; i++)
+		value = reduce(value, results[i]);
+	return value;
+}
+
+
+#endif // _JOB_SYSTEM_H_
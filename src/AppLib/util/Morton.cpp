@@ -0,0 +1,86 @@
+#include "Morton.h"
+
+
+//-----------------------------------------------------------------------------
+// Morton
+//-----------------------------------------------------------------------------
+
+// Spread the low 16 bits of a value out into the even bits.
+unsigned int Morton::Spread(unsigned int value)
+{
+	value &= 0x0000FFFF;
+	value = (value | (value << 8)) & 0x00FF00FF;
+	value = (value | (value << 4)) & 0x0F0F0F0F;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+
+unsigned int Morton::Encode(unsigned int x, unsigned int y)
+{
+	return Spread(x) | (Spread(y) << 1);
+}
+
+unsigned int Morton::Encode(float x, float y, float width, float height)
+{
+	float u = (width > 0.0f ? x / width : 0.0f);
+	float v = (height > 0.0f ? y / height : 0.0f);
+	u = (u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u));
+	v = (v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v));
+	return Encode((unsigned int) (u * 65535.0f), (unsigned int) (v * 65535.0f));
+}
+
+
+//-----------------------------------------------------------------------------
+// MortonSorter
+//-----------------------------------------------------------------------------
+
+MortonSorter::MortonSorter()
+	: m_width(1.0f)
+	, m_height(1.0f)
+{
+}
+
+void MortonSorter::Begin(int count, float width, float height)
+{
+	m_width = width;
+	m_height = height;
+	m_keys.resize(count);
+	m_tempKeys.resize(count);
+	m_order.resize(count);
+	m_tempOrder.resize(count);
+	for (int i = 0; i < count; i++)
+		m_order[i] = i;
+}
+
+void MortonSorter::SetPoint(int index, float x, float y)
+{
+	m_keys[index] = Morton::Encode(x, y, m_width, m_height);
+}
+
+const std::vector<int>& MortonSorter::Sort()
+{
+	int count = (int) m_keys.size();
+
+	// Least significant digit radix sort, 8 bits per pass.
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		int offsets[257] = { 0 };
+		for (int i = 0; i < count; i++)
+			offsets[((m_keys[i] >> shift) & 0xFF) + 1]++;
+		for (int i = 0; i < 256; i++)
+			offsets[i + 1] += offsets[i];
+
+		for (int i = 0; i < count; i++)
+		{
+			int dest = offsets[(m_keys[i] >> shift) & 0xFF]++;
+			m_tempKeys[dest] = m_keys[i];
+			m_tempOrder[dest] = m_order[i];
+		}
+
+		m_keys.swap(m_tempKeys);
+		m_order.swap(m_tempOrder);
+	}
+
+	return m_order;
+}
@@ -0,0 +1,54 @@
+#ifndef _MORTON_H_
+#define _MORTON_H_
+
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Morton - Z-order curve codes for 2D points. Points which are close in the
+// plane tend to be close in Z-order, so sorting by Morton code gives a
+// spatially coherent order.
+//-----------------------------------------------------------------------------
+class Morton
+{
+public:
+	// Interleave the bits of two 16-bit coordinates (x in the even bits).
+	static unsigned int Encode(unsigned int x, unsigned int y);
+
+	// Get the Morton code of a point within a region starting at the origin.
+	// Points outside the region are clamped to its edges.
+	static unsigned int Encode(float x, float y, float width, float height);
+
+private:
+	static unsigned int Spread(unsigned int value);
+};
+
+
+//-----------------------------------------------------------------------------
+// MortonSorter - finds the order that sorts a set of points by Morton code.
+// This is a stable radix sort, so points with equal codes keep their
+// relative order. Its buffers are kept between sorts to avoid allocations.
+//-----------------------------------------------------------------------------
+class MortonSorter
+{
+public:
+	MortonSorter();
+
+	// Begin a new sort of the given number of points.
+	void Begin(int count, float width, float height);
+	void SetPoint(int index, float x, float y);
+
+	// Sort the points. The result is a list of point indices, in order.
+	const std::vector<int>& Sort();
+
+private:
+	float						m_width;
+	float						m_height;
+	std::vector<unsigned int>	m_keys;
+	std::vector<unsigned int>	m_tempKeys;
+	std::vector<int>			m_order;
+	std::vector<int>			m_tempOrder;
+};
+
+
+#endif // _MORTON_H_
@@ -75,6 +75,12 @@ public:
         return (unsigned int) (m_seed / 65536) % 32768;
     }
 	
+	// Inclusive to Exclusive
+	inline int NextInt(int min, int max)
+	{
+		return (min + (NextInt() % (max - min)));
+	}
+	
 	inline bool NextBool()
 	{
 		return ((NextInt() % 2) == 0);
@@ -119,4 +125,55 @@ private:
 typedef RandomNumberGenerator RNG;
 
 
+// Four linear congruential generators stepped side by side, so that loops
+// filling arrays with random numbers can be vectorized by the compiler.
+class RandomNumberGenerator4
+{
+public:
+	static const int RANDOM_MAX = 32767;
+	
+public:
+	RandomNumberGenerator4(unsigned long seed = 1)
+	{
+		SetSeed(seed);
+	}
+
+	//-----------------------------------------------------------------------------
+
+	// Fill an array with random floats between 0 and 1.
+	inline void NextFloats(float* values, int count)
+	{
+		const float scale = 1.0f / static_cast<float> (RANDOM_MAX);
+		int i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				m_seeds[lane] = (m_seeds[lane] * 1103515245u) + 12345u;
+				values[i + lane] = static_cast<float> ((m_seeds[lane] >> 16) & 0x7FFF) * scale;
+			}
+		}
+
+		for (int lane = 0; i < count; i++, lane++)
+		{
+			m_seeds[lane] = (m_seeds[lane] * 1103515245u) + 12345u;
+			values[i] = static_cast<float> ((m_seeds[lane] >> 16) & 0x7FFF) * scale;
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+
+	void SetSeed(unsigned long seed)
+	{
+		// Spread the lanes apart so they don't produce correlated sequences.
+		for (int lane = 0; lane < 4; lane++)
+			m_seeds[lane] = static_cast<unsigned int> (seed) + (lane * 0x9E3779B9u);
+	}
+
+private:
+	unsigned int m_seeds[4];
+};
+
+
 #endif // _RANDOM_H_
\ No newline at end of file
@@ -1,15 +1,23 @@
 #include "FittestList.h"
 #include <ArtificialLife/agent/Agent.h>
+#include <algorithm>
 #include <assert.h>
 
 FittestList::FittestList(int capacity)
 	: m_capacity(capacity)
+	, m_size(0)
+	, m_isRankSorted(true)
+	, m_totalFitness(0.0)
+	, m_bestFitness(0.0f)
 {
-	m_fittest = new Fittest*[m_capacity];
+	// The entries and their genomes are allocated up front, and reused.
+	m_heap = new Fittest*[m_capacity];
+	m_ranks = new Fittest*[m_capacity];
 	for (int i = 0; i < m_capacity; i++)
 	{
-		m_fittest[i] = new Fittest();
-		m_fittest[i]->genome = new BrainGenome();
+		m_heap[i] = new Fittest();
+		m_heap[i]->genome = new BrainGenome();
+		m_ranks[i] = m_heap[i];
 	}
 }
 
@@ -17,11 +25,13 @@ FittestList::~FittestList()
 {
 	for (int i = 0; i < m_capacity; i++)
 	{
-		delete m_fittest[i]->genome;
-		delete m_fittest[i];
+		delete m_heap[i]->genome;
+		delete m_heap[i];
 	}
-	delete [] m_fittest;
-	m_fittest = NULL;
+	delete [] m_heap;
+	delete [] m_ranks;
+	m_heap = NULL;
+	m_ranks = NULL;
 }
 
 
@@ -43,50 +53,105 @@ bool FittestList::IsFull() const
 void FittestList::Clear()
 {
 	m_size = 0;
+	m_isRankSorted = true;
+	m_totalFitness = 0.0;
+	m_bestFitness = 0.0f;
 }
 
 void FittestList::Update(Agent* agent, float fitness)
 {
-	if (!IsFull() || fitness > m_fittest[m_size - 1]->fitness)
+	int index;
+
+	if (!IsFull())
+		index = m_size++; // Add a new element to the end of the heap.
+	else if (m_capacity > 0 && fitness > m_heap[0]->fitness)
+		index = 0; // Replace the least fit element.
+	else
+		return;
+
+	Fittest* element = m_heap[index];
+	if (index == 0 && IsFull())
+		m_totalFitness -= element->fitness;
+	if (m_size == 1 || fitness > m_bestFitness)
+		m_bestFitness = fitness;
+	m_totalFitness += fitness;
+	element->fitness = fitness;
+	element->agentID = agent->GetID();
+	element->genome->Swap(*agent->GetGenome());
+
+	// A new element can only move up the heap, and a replaced least fit
+	// element can only move down.
+	if (index == 0)
+		SiftDown(0);
+	else
+		SiftUp(index);
+
+	m_isRankSorted = false;
+}
+
+Fittest* FittestList::GetByRank(int rank)
+{
+	assert(rank >= 0 && rank < m_size);
+
+	if (!m_isRankSorted)
 	{
-		// Determine the rank of the new agent.
-		int rank = 0;
 		for (int i = 0; i < m_size; i++)
-		{
-			if (fitness > m_fittest[i]->fitness)
-			{
-				rank = i;
-				break;
-			}
-		}
-
-		if (rank < 0)
-		{
-			assert(false); // This shouldn't happen.
-		}
-
-		// Increase the size if the list isn't full yet.
-		// Otherwise, the lowest rank agent will be forgot.
-		if (!IsFull())
-		{
-			m_size++;
-		}
-		
-		// Shift other agents up (down in rank).
-		Fittest* newElement = m_fittest[m_size - 1];
-		for (int i = m_size - 1; i > rank; i--)
-			m_fittest[i] = m_fittest[i - 1];
-		m_fittest[rank] = newElement;
-		
-		// Add in the new agent at its appropriate rank.
-		newElement->fitness = fitness;
-		newElement->agentID	= agent->GetID();
-		newElement->genome->CopyFrom(agent->GetGenome());
+			m_ranks[i] = m_heap[i];
+		std::sort(m_ranks, m_ranks + m_size, [](const Fittest* a, const Fittest* b) {
+			return (a->fitness > b->fitness);
+		});
+		m_isRankSorted = true;
 	}
+
+	return m_ranks[rank];
 }
 
-Fittest* FittestList::GetByRank(int rank)
+float FittestList::GetBestFitness() const
+{
+	return (m_size > 0 ? m_bestFitness : 0.0f);
+}
+
+float FittestList::GetWorstFitness() const
 {
-	return m_fittest[rank];
+	return (m_size > 0 ? m_heap[0]->fitness : 0.0f);
 }
 
+float FittestList::GetAverageFitness() const
+{
+	return (m_size > 0 ? (float) (m_totalFitness / m_size) : 0.0f);
+}
+
+
+//-----------------------------------------------------------------------------
+// Heap.
+//-----------------------------------------------------------------------------
+
+void FittestList::SiftUp(int index)
+{
+	while (index > 0)
+	{
+		int parent = (index - 1) / 2;
+		if (m_heap[parent]->fitness <= m_heap[index]->fitness)
+			break;
+		std::swap(m_heap[parent], m_heap[index]);
+		index = parent;
+	}
+}
+
+void FittestList::SiftDown(int index)
+{
+	while (true)
+	{
+		int smallest = index;
+		int left = (2 * index) + 1;
+		int right = left + 1;
+		if (left < m_size && m_heap[left]->fitness < m_heap[smallest]->fitness)
+			smallest = left;
+		if (right < m_size && m_heap[right]->fitness < m_heap[smallest]->fitness)
+			smallest = right;
+		if (smallest == index)
+			break;
+		std::swap(m_heap[index], m_heap[smallest]);
+		index = smallest;
+	}
+}
@@ -21,6 +21,9 @@ struct Fittest
 };
 
 
+// The fittest agents are kept in a min-heap on fitness, so that the least
+// fit one can be replaced in O(log n). The ranking is only sorted when it
+// is asked for after the list has changed.
 class FittestList
 {
 public:
@@ -32,14 +35,31 @@ public:
 	bool IsFull() const;
 	void Clear();
 
+	// Add a dying agent to the list if it is fit enough. Its genome is
+	// swapped into the list rather than copied, so the agent must not be
+	// used afterwards (other than to delete it).
 	void Update(Agent* agent, float fitness);
 
+	// Rank 0 is the fittest.
 	Fittest* GetByRank(int rank);
 
+	// These are kept up to date as the list changes, so they don't need the
+	// ranking to be sorted. They are zero for an empty list.
+	float GetBestFitness() const;
+	float GetWorstFitness() const;
+	float GetAverageFitness() const;
+
 private:
-	int m_capacity;
-	int m_size;
-	Fittest** m_fittest;
+	void SiftUp(int index);
+	void SiftDown(int index);
+
+	int			m_capacity;
+	int			m_size;
+	Fittest**	m_heap;			// Min-heap on fitness (the least fit is first).
+	Fittest**	m_ranks;		// Sorted by fitness, from the fittest.
+	bool		m_isRankSorted;
+	double		m_totalFitness;
+	float		m_bestFitness;
 };
 
 
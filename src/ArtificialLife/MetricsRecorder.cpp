@@ -0,0 +1,270 @@
+#include "MetricsRecorder.h"
+#include <ArtificialLife/Simulation.h>
+#include <iostream>
+#include <string.h>
+#include <assert.h>
+
+
+struct MetricInfo
+{
+	const char*	name;
+	MetricType	type;
+};
+
+// Indexed by Metric.
+static const MetricInfo g_metricInfos[NUM_METRICS] =
+{
+	{ "world_age",						METRIC_TYPE_INT },
+	{ "num_agents",						METRIC_TYPE_INT },
+	{ "num_food",						METRIC_TYPE_INT },
+	{ "num_agents_born",				METRIC_TYPE_INT },
+	{ "num_agents_dead_old_age",		METRIC_TYPE_INT },
+	{ "num_agents_dead_energy",			METRIC_TYPE_INT },
+	{ "num_agents_created_mate",		METRIC_TYPE_INT },
+	{ "num_agents_created_random",		METRIC_TYPE_INT },
+	{ "num_births_denied",				METRIC_TYPE_INT },
+	{ "avg_size",						METRIC_TYPE_FLOAT },
+	{ "avg_strength",					METRIC_TYPE_FLOAT },
+	{ "avg_fov",						METRIC_TYPE_FLOAT },
+	{ "avg_max_speed",					METRIC_TYPE_FLOAT },
+	{ "avg_green_color",				METRIC_TYPE_FLOAT },
+	{ "avg_mutation_rate",				METRIC_TYPE_FLOAT },
+	{ "avg_num_crossover_points",		METRIC_TYPE_FLOAT },
+	{ "avg_life_span",					METRIC_TYPE_FLOAT },
+	{ "avg_birth_energy_fraction",		METRIC_TYPE_FLOAT },
+	{ "avg_num_red_neurons",			METRIC_TYPE_FLOAT },
+	{ "avg_num_green_neurons",			METRIC_TYPE_FLOAT },
+	{ "avg_num_blue_neurons",			METRIC_TYPE_FLOAT },
+	{ "avg_num_internal_neur_groups",	METRIC_TYPE_FLOAT },
+	{ "avg_num_neurons",				METRIC_TYPE_FLOAT },
+	{ "avg_num_synapses",				METRIC_TYPE_FLOAT },
+	{ "avg_learning_synapse_fraction",	METRIC_TYPE_FLOAT },
+	{ "avg_eat_amount",					METRIC_TYPE_FLOAT },
+	{ "avg_mate_amount",				METRIC_TYPE_FLOAT },
+	{ "avg_fight_amount",				METRIC_TYPE_FLOAT },
+	{ "worst_fitness",					METRIC_TYPE_FLOAT },
+	{ "avg_fitness",					METRIC_TYPE_FLOAT },
+	{ "best_fitness",					METRIC_TYPE_FLOAT },
+	{ "total_energy",					METRIC_TYPE_FLOAT },
+	{ "avg_energy",						METRIC_TYPE_FLOAT },
+	{ "avg_energy_usage",				METRIC_TYPE_FLOAT },
+	{ "tick_time",						METRIC_TYPE_FLOAT },
+	{ "tick_time_agents",				METRIC_TYPE_FLOAT },
+	{ "tick_time_steady_state_ga",		METRIC_TYPE_FLOAT },
+	{ "tick_time_food",					METRIC_TYPE_FLOAT },
+	{ "tick_time_prebirth",				METRIC_TYPE_FLOAT },
+};
+
+
+MetricsRecorder::MetricsRecorder(Simulation* simulation)
+	: m_simulation(simulation)
+	, m_isRecording(false)
+	, m_isStopping(false)
+{
+}
+
+MetricsRecorder::~MetricsRecorder()
+{
+	if (m_isRecording)
+		StopRecording();
+}
+
+const char* MetricsRecorder::GetMetricName(Metric metric)
+{
+	return g_metricInfos[metric].name;
+}
+
+MetricType MetricsRecorder::GetMetricType(Metric metric)
+{
+	return g_metricInfos[metric].type;
+}
+
+bool MetricsRecorder::BeginRecording(const std::string& path)
+{
+	assert(m_isRecording == false);
+
+	m_binaryFile.open(path + ".metrics", std::ios::out | std::ios::binary);
+	m_csvFile.open(path + ".csv", std::ios::out);
+	if (!m_binaryFile.is_open() || !m_csvFile.is_open())
+	{
+		std::cout << "WARNING: could not open metrics files " << path << ".metrics/.csv" << std::endl;
+		m_binaryFile.close();
+		m_csvFile.close();
+		return false;
+	}
+
+	// Write the binary header and column descriptions.
+	MetricsFileHeader header;
+	header.magic[0] = 'c';
+	header.magic[1] = 'm';
+	header.magic[2] = 'a';
+	header.magic[3] = 'm';
+	header.version = 1;
+	header.numColumns = NUM_METRICS;
+	m_binaryFile.write((char*) &header, sizeof(MetricsFileHeader));
+	for (int i = 0; i < NUM_METRICS; i++)
+	{
+		unsigned char type = (unsigned char) g_metricInfos[i].type;
+		m_binaryFile.write((char*) &type, 1);
+		m_binaryFile.write(g_metricInfos[i].name, strlen(g_metricInfos[i].name) + 1);
+	}
+
+	// Write the CSV header.
+	for (int i = 0; i < NUM_METRICS; i++)
+		m_csvFile << (i > 0 ? "," : "") << g_metricInfos[i].name;
+	m_csvFile << std::endl;
+
+	m_block.reserve(BLOCK_SIZE);
+	m_isStopping = false;
+	m_writerThread = std::thread(&MetricsRecorder::WriterThread, this);
+	m_isRecording = true;
+	return true;
+}
+
+void MetricsRecorder::RecordSample()
+{
+	assert(m_isRecording == true);
+
+	const SimulationStats& stats = m_simulation->GetStatistics();
+	const TickProfiler& profiler = m_simulation->GetProfiler();
+
+	m_block.push_back(MetricsRow());
+	MetricValue* values = m_block.back().values;
+
+	values[METRIC_WORLD_AGE].i						= m_simulation->GetWorldAge();
+	values[METRIC_NUM_AGENTS].i						= m_simulation->GetNumAgents();
+	values[METRIC_NUM_FOOD].i						= m_simulation->GetNumFood();
+	values[METRIC_NUM_AGENTS_BORN].i				= stats.numAgentsBorn;
+	values[METRIC_NUM_AGENTS_DEAD_OLD_AGE].i		= stats.numAgentsDeadOldAge;
+	values[METRIC_NUM_AGENTS_DEAD_ENERGY].i			= stats.numAgentsDeadEnergy;
+	values[METRIC_NUM_AGENTS_CREATED_MATE].i		= stats.numAgentsCreatedMate;
+	values[METRIC_NUM_AGENTS_CREATED_RANDOM].i		= stats.numAgentsCreatedRandom;
+	values[METRIC_NUM_BIRTHS_DENIED].i				= stats.numBirthsDenied;
+	values[METRIC_AVG_SIZE].f						= stats.avgSize;
+	values[METRIC_AVG_STRENGTH].f					= stats.avgStrength;
+	values[METRIC_AVG_FOV].f						= stats.avgFOV;
+	values[METRIC_AVG_MAX_SPEED].f					= stats.avgMaxSpeed;
+	values[METRIC_AVG_GREEN_COLOR].f				= stats.avgGreenColor;
+	values[METRIC_AVG_MUTATION_RATE].f				= stats.avgMutationRate;
+	values[METRIC_AVG_NUM_CROSSOVER_POINTS].f		= stats.avgNumCrossoverPoints;
+	values[METRIC_AVG_LIFE_SPAN].f					= stats.avgLifeSpan;
+	values[METRIC_AVG_BIRTH_ENERGY_FRACTION].f		= stats.avgBirthEnergyFraction;
+	values[METRIC_AVG_NUM_RED_NEURONS].f			= stats.avgNumRedNeurons;
+	values[METRIC_AVG_NUM_GREEN_NEURONS].f			= stats.avgNumGreenNeurons;
+	values[METRIC_AVG_NUM_BLUE_NEURONS].f			= stats.avgNumBlueNeurons;
+	values[METRIC_AVG_NUM_INTERNAL_NEUR_GROUPS].f	= stats.avgNumInternalNeurGroups;
+	values[METRIC_AVG_NUM_NEURONS].f				= stats.avgNumNeurons;
+	values[METRIC_AVG_NUM_SYNAPSES].f				= stats.avgNumSynapses;
+	values[METRIC_AVG_LEARNING_SYNAPSE_FRACTION].f	= stats.avgLearningSynapseFraction;
+	values[METRIC_AVG_EAT_AMOUNT].f					= stats.avgEatAmount;
+	values[METRIC_AVG_MATE_AMOUNT].f				= stats.avgMateAmount;
+	values[METRIC_AVG_FIGHT_AMOUNT].f				= stats.avgFightAmount;
+	values[METRIC_WORST_FITNESS].f					= stats.worstFitness;
+	values[METRIC_AVG_FITNESS].f					= stats.avgFitness;
+	values[METRIC_BEST_FITNESS].f					= stats.bestFitness;
+	values[METRIC_TOTAL_ENERGY].f					= stats.totalEnergy;
+	values[METRIC_AVG_ENERGY].f						= stats.avgEnergy;
+	values[METRIC_AVG_ENERGY_USAGE].f				= stats.avgEnergyUsage;
+	values[METRIC_TICK_TIME].f						= (float) profiler.GetTickTime();
+	values[METRIC_TICK_TIME_AGENTS].f				= (float) profiler.GetPhaseTime(TICK_PHASE_AGENTS);
+	values[METRIC_TICK_TIME_STEADY_STATE_GA].f		= (float) profiler.GetPhaseTime(TICK_PHASE_STEADY_STATE_GA);
+	values[METRIC_TICK_TIME_FOOD].f					= (float) profiler.GetPhaseTime(TICK_PHASE_FOOD);
+	values[METRIC_TICK_TIME_PREBIRTH].f				= (float) profiler.GetPhaseTime(TICK_PHASE_PREBIRTH);
+
+	if ((int) m_block.size() >= BLOCK_SIZE)
+		QueueBlock();
+}
+
+void MetricsRecorder::StopRecording()
+{
+	assert(m_isRecording == true);
+
+	// Write the remaining rows and wait for the writer to finish.
+	if (!m_block.empty())
+		QueueBlock();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_condition.notify_one();
+	m_writerThread.join();
+
+	m_binaryFile.close();
+	m_csvFile.close();
+	m_isRecording = false;
+}
+
+// Hand the current block of rows over to the writer thread.
+void MetricsRecorder::QueueBlock()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(row_block());
+		m_queue.back().swap(m_block);
+		if (!m_freeBlocks.empty())
+		{
+			m_block.swap(m_freeBlocks.back());
+			m_freeBlocks.pop_back();
+		}
+	}
+	m_condition.notify_one();
+	m_block.reserve(BLOCK_SIZE);
+}
+
+void MetricsRecorder::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_condition.wait(lock, [this]() { return !m_queue.empty() || m_isStopping; });
+		if (m_queue.empty())
+			break;
+
+		row_block block;
+		block.swap(m_queue.front());
+		m_queue.erase(m_queue.begin());
+
+		// Write without holding the lock, so recording is never blocked on
+		// file IO.
+		lock.unlock();
+		WriteBlock(block);
+		block.clear();
+		lock.lock();
+
+		m_freeBlocks.push_back(row_block());
+		m_freeBlocks.back().swap(block);
+	}
+}
+
+void MetricsRecorder::WriteBlock(const row_block& block)
+{
+	int numRows = (int) block.size();
+
+	// Binary: the block's rows, one column at a time.
+	std::vector<MetricValue> column(numRows);
+	m_binaryFile.write((char*) &numRows, sizeof(int));
+	for (int j = 0; j < NUM_METRICS; j++)
+	{
+		for (int i = 0; i < numRows; i++)
+			column[i] = block[i].values[j];
+		m_binaryFile.write((char*) column.data(), numRows * sizeof(MetricValue));
+	}
+	m_binaryFile.flush();
+
+	// CSV: one line per row.
+	for (int i = 0; i < numRows; i++)
+	{
+		for (int j = 0; j < NUM_METRICS; j++)
+		{
+			if (j > 0)
+				m_csvFile << ",";
+			if (g_metricInfos[j].type == METRIC_TYPE_INT)
+				m_csvFile << block[i].values[j].i;
+			else
+				m_csvFile << block[i].values[j].f;
+		}
+		m_csvFile << "\n";
+	}
+	m_csvFile.flush();
+}
@@ -0,0 +1,141 @@
+#ifndef _METRICS_RECORDER_H_
+#define _METRICS_RECORDER_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class Simulation;
+
+
+// The columns of a metrics row.
+enum Metric
+{
+	METRIC_WORLD_AGE = 0,
+	METRIC_NUM_AGENTS,
+	METRIC_NUM_FOOD,
+	METRIC_NUM_AGENTS_BORN,
+	METRIC_NUM_AGENTS_DEAD_OLD_AGE,
+	METRIC_NUM_AGENTS_DEAD_ENERGY,
+	METRIC_NUM_AGENTS_CREATED_MATE,
+	METRIC_NUM_AGENTS_CREATED_RANDOM,
+	METRIC_NUM_BIRTHS_DENIED,
+	METRIC_AVG_SIZE,
+	METRIC_AVG_STRENGTH,
+	METRIC_AVG_FOV,
+	METRIC_AVG_MAX_SPEED,
+	METRIC_AVG_GREEN_COLOR,
+	METRIC_AVG_MUTATION_RATE,
+	METRIC_AVG_NUM_CROSSOVER_POINTS,
+	METRIC_AVG_LIFE_SPAN,
+	METRIC_AVG_BIRTH_ENERGY_FRACTION,
+	METRIC_AVG_NUM_RED_NEURONS,
+	METRIC_AVG_NUM_GREEN_NEURONS,
+	METRIC_AVG_NUM_BLUE_NEURONS,
+	METRIC_AVG_NUM_INTERNAL_NEUR_GROUPS,
+	METRIC_AVG_NUM_NEURONS,
+	METRIC_AVG_NUM_SYNAPSES,
+	METRIC_AVG_LEARNING_SYNAPSE_FRACTION,
+	METRIC_AVG_EAT_AMOUNT,
+	METRIC_AVG_MATE_AMOUNT,
+	METRIC_AVG_FIGHT_AMOUNT,
+	METRIC_WORST_FITNESS,
+	METRIC_AVG_FITNESS,
+	METRIC_BEST_FITNESS,
+	METRIC_TOTAL_ENERGY,
+	METRIC_AVG_ENERGY,
+	METRIC_AVG_ENERGY_USAGE,
+	METRIC_TICK_TIME,
+	METRIC_TICK_TIME_AGENTS,
+	METRIC_TICK_TIME_STEADY_STATE_GA,
+	METRIC_TICK_TIME_FOOD,
+	METRIC_TICK_TIME_PREBIRTH,
+
+	NUM_METRICS,
+};
+
+enum MetricType
+{
+	METRIC_TYPE_INT = 0,
+	METRIC_TYPE_FLOAT,
+};
+
+union MetricValue
+{
+	int		i;
+	float	f;
+};
+
+struct MetricsRow
+{
+	MetricValue values[NUM_METRICS];
+};
+
+
+// The binary metrics file is stored in columns, in blocks of rows:
+//
+//   MetricsFileHeader
+//   for each column: MetricType (1 byte), name (null-terminated)
+//   for each block:  row count (int), then for each column, that many
+//                    4-byte values
+//
+// A block is written every MetricsRecorder::BLOCK_SIZE rows, and when
+// recording stops, so a file is readable up to its last complete block.
+struct MetricsFileHeader
+{
+	unsigned char magic[4];
+	int version;
+	int numColumns;
+};
+
+
+//-----------------------------------------------------------------------------
+// MetricsRecorder - records the simulation statistics every sample interval
+// to a columnar binary file and a CSV file. Rows are buffered into blocks,
+// which are written by a background thread.
+//-----------------------------------------------------------------------------
+class MetricsRecorder
+{
+public:
+	static const int BLOCK_SIZE = 256;
+
+	MetricsRecorder(Simulation* simulation);
+	~MetricsRecorder();
+
+	// Begin writing to <path>.metrics and <path>.csv. Returns false if the
+	// files could not be opened.
+	bool BeginRecording(const std::string& path);
+	void RecordSample();
+	void StopRecording();
+
+	bool IsRecording() const { return m_isRecording; }
+
+	static const char* GetMetricName(Metric metric);
+	static MetricType GetMetricType(Metric metric);
+
+private:
+	typedef std::vector<MetricsRow> row_block;
+
+	void QueueBlock();
+	void WriterThread();
+	void WriteBlock(const row_block& block);
+
+	Simulation*				m_simulation;
+	std::ofstream			m_binaryFile;
+	std::ofstream			m_csvFile;
+	bool					m_isRecording;
+
+	row_block				m_block;		// Rows being recorded.
+	std::vector<row_block>	m_queue;		// Blocks waiting to be written.
+	std::vector<row_block>	m_freeBlocks;	// Written blocks, reused to avoid allocations.
+	std::thread				m_writerThread;
+	std::mutex				m_mutex;
+	std::condition_variable	m_condition;
+	bool					m_isStopping;
+};
+
+
+#endif // _METRICS_RECORDER_H_
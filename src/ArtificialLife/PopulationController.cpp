@@ -0,0 +1,96 @@
+#include "PopulationController.h"
+#include <ArtificialLife/Simulation.h>
+#include <AppLib/math/MathLib.h>
+#include <iostream>
+
+
+// How much the population cap changes in each adjustment. It is lowered
+// faster than it is raised, as a slow simulation is worse than a small one.
+static const float CAP_DECREASE_FRACTION = 0.1f;
+static const float CAP_INCREASE_FRACTION = 0.05f;
+
+// The population must have come this close to the cap during the interval
+// for the cap to be raised.
+static const float CAP_PRESSURE_FRACTION = 0.9f;
+
+
+PopulationController::PopulationController()
+{
+	Reset();
+}
+
+void PopulationController::Reset()
+{
+	m_maxAgents		= Simulation::PARAMS.maxAgents;
+	m_foodLevel		= Simulation::PARAMS.minFood;
+	m_totalTickTime	= 0.0;
+	m_numTicks		= 0;
+	m_maxNumAgents	= 0;
+	m_avgTickTime	= 0.0;
+}
+
+void PopulationController::Update(double tickTime, int numAgents)
+{
+	if (!IsEnabled())
+		return;
+
+	m_totalTickTime += tickTime;
+	m_numTicks++;
+	m_maxNumAgents = Math::Max(m_maxNumAgents, numAgents);
+	if (m_numTicks < Math::Max(1, Simulation::PARAMS.populationControlInterval))
+		return;
+
+	m_avgTickTime = m_totalTickTime / m_numTicks;
+	double targetTickTime = 1.0 / Simulation::PARAMS.targetTicksPerSecond;
+	double hysteresis = Simulation::PARAMS.populationControlHysteresis;
+
+	if (m_avgTickTime > targetTickTime * (1.0 + hysteresis))
+	{
+		// Too slow: lower the cap below the current population, so it takes
+		// effect straight away. Agents aren't removed when the cap drops, so
+		// wait until the population has come down to the last cap before
+		// lowering it again, otherwise the cap would keep falling while the
+		// tick time still reflects the old population.
+		if (m_maxNumAgents <= m_maxAgents)
+		{
+			int cap = Math::Min(m_maxAgents, m_maxNumAgents);
+			SetMaxAgents((int) (cap * (1.0f - CAP_DECREASE_FRACTION)));
+		}
+	}
+	else if (m_avgTickTime < targetTickTime * (1.0 - hysteresis) &&
+			 m_maxNumAgents >= (int) (m_maxAgents * CAP_PRESSURE_FRACTION))
+	{
+		// Fast enough, and the cap is holding the population back.
+		SetMaxAgents(m_maxAgents + Math::Max(1, (int) (m_maxAgents * CAP_INCREASE_FRACTION)));
+	}
+
+	m_totalTickTime	= 0.0;
+	m_numTicks		= 0;
+	m_maxNumAgents	= 0;
+}
+
+bool PopulationController::IsEnabled() const
+{
+	return (Simulation::PARAMS.targetTicksPerSecond > 0.0f);
+}
+
+void PopulationController::SetMaxAgents(int maxAgents)
+{
+	maxAgents = Math::Clamp(maxAgents, Simulation::PARAMS.minAgents, Simulation::PARAMS.maxAgents);
+	if (maxAgents == m_maxAgents)
+		return;
+
+	// Scale the food with the cap, so a full population has as much food per
+	// agent as it would without the controller.
+	int foodLevel = Math::Max(1, (int) ((float) Simulation::PARAMS.minFood *
+		maxAgents / Simulation::PARAMS.maxAgents + 0.5f));
+
+	std::cout << "Population cap " << (maxAgents < m_maxAgents ? "lowered" : "raised")
+		<< " from " << m_maxAgents << " to " << maxAgents
+		<< ", food level " << m_foodLevel << " to " << foodLevel
+		<< " (tick = " << (m_avgTickTime * 1000.0) << " ms, target = "
+		<< (1000.0 / Simulation::PARAMS.targetTicksPerSecond) << " ms)" << std::endl;
+
+	m_maxAgents = maxAgents;
+	m_foodLevel = foodLevel;
+}
@@ -0,0 +1,46 @@
+#ifndef _POPULATION_CONTROLLER_H_
+#define _POPULATION_CONTROLLER_H_
+
+
+//-----------------------------------------------------------------------------
+// PopulationController - keeps the simulation running at a target number of
+// ticks per second by adjusting the population cap and the food level. The
+// tick time is averaged over each control interval. If it is too slow by
+// more than the hysteresis, the cap is lowered, but only once the population
+// has died down to the previous cap. If it is fast enough by more
+// than the hysteresis and the population is pressing against the cap, the
+// cap is raised. The cap stays between the minimum and maximum number of
+// agents in the simulation parameters, and the food level is scaled with it.
+//-----------------------------------------------------------------------------
+class PopulationController
+{
+public:
+	PopulationController();
+
+	// Reset the caps to the simulation parameters.
+	void Reset();
+
+	// Add the time a tick took, in seconds, and adjust the caps at the end of
+	// each control interval.
+	void Update(double tickTime, int numAgents);
+
+	bool IsEnabled() const;
+	int GetMaxAgents() const { return m_maxAgents; }
+	int GetFoodLevel() const { return m_foodLevel; }
+
+	// The average tick time over the last control interval, in seconds.
+	double GetAverageTickTime() const { return m_avgTickTime; }
+
+private:
+	void SetMaxAgents(int maxAgents);
+
+	int		m_maxAgents;
+	int		m_foodLevel;
+	double	m_totalTickTime; // Accumulated during the current interval.
+	int		m_numTicks;
+	int		m_maxNumAgents;  // Largest population during the current interval.
+	double	m_avgTickTime;
+};
+
+
+#endif // _POPULATION_CONTROLLER_H_
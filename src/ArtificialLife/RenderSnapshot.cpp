@@ -0,0 +1,48 @@
+#include "RenderSnapshot.h"
+#include <AppLib/math/MathLib.h>
+
+
+//-----------------------------------------------------------------------------
+// SelectedAgentSnapshot
+//-----------------------------------------------------------------------------
+
+// Matches Retina::GetInterpolatedSightValue().
+float SelectedAgentSnapshot::GetInterpolatedSightValue(int channel, float x) const
+{
+	int numNeurons = (int) sight[channel].size();
+	
+	if (numNeurons == 0)
+	{
+		return 0.0f;
+	}
+	else if (numNeurons == 1)
+	{
+		return sight[channel][0];
+	}
+	else
+	{
+		x = Math::Clamp(x, 0.0f, 1.0f);
+
+		float neuronIndex = (x * numNeurons) - 0.5f;
+		int neuron0 = Math::Max((int) neuronIndex + 0, 0);
+		int neuron1 = Math::Min((int) neuronIndex + 1, numNeurons - 1);
+		float t = neuronIndex - (float) neuron0;
+
+		return Math::Lerp(sight[channel][neuron0], sight[channel][neuron1], t);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// RenderSnapshot
+//-----------------------------------------------------------------------------
+
+const AgentSnapshot* RenderSnapshot::GetAgent(unsigned long id) const
+{
+	for (unsigned int i = 0; i < agents.size(); i++)
+	{
+		if (agents[i].id == id)
+			return &agents[i];
+	}
+	return NULL;
+}
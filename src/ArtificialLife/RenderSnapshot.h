@@ -0,0 +1,128 @@
+#ifndef _RENDER_SNAPSHOT_H_
+#define _RENDER_SNAPSHOT_H_
+
+#include <AppLib/math/Vector2f.h>
+#include <AppLib/math/Vector3f.h>
+#include <AppLib/graphics/Color.h>
+#include <ArtificialLife/brain/NeuronModel.h>
+#include <ArtificialLife/TickProfiler.h>
+#include <ArtificialLife/Simulation.h>
+#include <vector>
+
+
+// Number of sight colors kept for each agent, for drawing its vision strip.
+#define SNAPSHOT_SIGHT_SAMPLES 32
+
+
+struct AgentSnapshot
+{
+	unsigned long	id;
+	Vector2f		position;
+	float			direction;
+	float			size;
+	float			fov;
+	float			eatRadius;
+	float			mateRadius;
+	float			fightRadius;
+	Color			color;
+	Vector3f		sight[SNAPSHOT_SIGHT_SAMPLES];
+};
+
+
+struct FoodSnapshot
+{
+	Vector2f	position;
+	float		size;
+	float		radius;
+};
+
+
+// Everything shown about the selected agent in the side panel and the brain
+// view.
+struct SelectedAgentSnapshot
+{
+	unsigned long	id; // 0 if no agent is selected.
+
+	int		age;
+	int		lifespan;
+	float	energy;
+	float	maxEnergy;
+	float	fitness;
+	float	moveSpeed;
+	float	maxSpeed;
+	float	turnSpeed;
+	float	mateAmount;
+	float	fightAmount;
+	float	eatAmount;
+	int		numFoodEaten;
+	int		numChildren;
+
+	float	size;
+	float	strength;
+	float	fov;
+	float	greenColoration;
+	float	mutationRate;
+	int		numCrossoverPoints;
+	int		genomeLifespan;
+	float	birthEnergyFraction;
+	int		numRedNeurons;
+	int		numGreenNeurons;
+	int		numBlueNeurons;
+	int		numInternalGroups;
+
+	// Sight values of each color channel.
+	std::vector<float> sight[3];
+
+	// The brain, with neurons in the order they were grown and synapses in
+	// the order they are stored, so the neurons' synapse ranges still apply.
+	NeuronModel::Dimensions	brainDimensions;
+	float					learningSynapseFraction;
+	std::vector<Neuron>		neurons;
+	std::vector<Synapse>	synapses;
+	std::vector<float>		activations;
+	std::vector<float>		prevActivations;
+	std::vector<int>		internalGroupSizes; // Number of neurons in each internal group.
+
+	SelectedAgentSnapshot()
+		: id(0)
+	{}
+
+	float GetInterpolatedSightValue(int channel, float x) const;
+};
+
+
+//-----------------------------------------------------------------------------
+// RenderSnapshot - a copy of what the UI draws of the simulation, taken at
+// the end of a tick. It lets the UI draw the world while the simulation is
+// busy with the next tick.
+//-----------------------------------------------------------------------------
+struct RenderSnapshot
+{
+	int							worldAge;
+	int							numAgents;
+	int							maxAgents; // The population cap.
+	int							numFood;
+	SimulationStats				stats;
+	bool						statisticsSampled; // If the stats were sampled during this tick.
+	double						tickTime;
+	double						phaseTimes[NUM_TICK_PHASES];
+	std::vector<AgentSnapshot>	agents;
+	std::vector<FoodSnapshot>	food;
+	SelectedAgentSnapshot		selectedAgent;
+
+	RenderSnapshot()
+		: worldAge(-1)
+		, numAgents(0)
+		, maxAgents(0)
+		, numFood(0)
+		, statisticsSampled(false)
+		, tickTime(0.0)
+	{}
+
+	// Find the agent with the given ID, returning NULL if it isn't in the
+	// snapshot.
+	const AgentSnapshot* GetAgent(unsigned long id) const;
+};
+
+
+#endif // _RENDER_SNAPSHOT_H_
@@ -64,14 +64,16 @@ void ReplayRecorder::RecordStep()
 	}
 
 	// Write food states.
-	for (auto it = m_simulation->food_begin(); it < m_simulation->food_end(); ++it)
+	const FoodField& food = m_simulation->GetFood();
+	for (int i = 0; i < food.GetNumSites(); i++)
 	{
-		Food* food = *it;
+		if (!food.IsActive(i))
+			continue;
 
 		ReplayFood replayFood;
-		replayFood.x	= food->GetPosition().x;
-		replayFood.y	= food->GetPosition().y;
-		replayFood.size	= food->GetSize();
+		replayFood.x	= food.GetPosition(i).x;
+		replayFood.y	= food.GetPosition(i).y;
+		replayFood.size	= food.GetSize(i);
 		m_file.write((char*) &replayFood, sizeof(ReplayFood));
 	}
 
@@ -1,76 +1,150 @@
 #include "Simulation.h"
+#include "RenderSnapshot.h"
 #include <AppLib/graphics/Graphics.h>
 #include <AppLib/math/MathLib.h>
 #include <AppLib/math/Vector4f.h>
+#include <AppLib/util/Timing.h>
 #include <ArtificialLife/brain/Brain.h>
 
 SimulationParams Simulation::PARAMS;
 
+// Narrowest width of the atlas that the agents' vision is rendered into.
+static const int VISION_ATLAS_WIDTH = 256;
+
+// How far away the agents can see.
+static const float VISION_FAR_PLANE = 1000.0f;
+
+
+
 
 Simulation::Simulation()
-	: m_fittestList(NULL)
+	: m_statisticsSampled(false)
+	, m_fittestList(NULL)
+	, m_jobSystem(NULL)
 	, m_agentVisionPixels(NULL)
+	, m_visionFramebuffer(0)
+	, m_visionResolveFramebuffer(0)
+	, m_visionPixelBuffer(0)
+	, m_visionTimerQuery(0)
+	, m_visionFence(NULL)
+	, m_numVisionAgents(0)
+	, m_visionAtlasWidth(0)
+	, m_visionAtlasHeight(0)
 	, m_worldRenderer(this)
 	, m_replayRecorder(this)
 {
+	for (int i = 0; i < 3; i++)
+		m_visionRenderbuffers[i] = 0;
 }
 
 Simulation::~Simulation()
 {
 	delete m_agentVisionPixels; m_agentVisionPixels = NULL;
+	if (m_visionFence != NULL)
+		glDeleteSync(m_visionFence);
+	if (m_visionPixelBuffer != 0)
+		glDeleteBuffers(1, &m_visionPixelBuffer);
+	if (m_visionTimerQuery != 0)
+		glDeleteQueries(1, &m_visionTimerQuery);
+	if (m_visionFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_visionFramebuffer);
+		glDeleteFramebuffers(1, &m_visionResolveFramebuffer);
+		glDeleteRenderbuffers(3, m_visionRenderbuffers);
+	}
 	
 	// Delete all agents.
 	for (unsigned int i = 0; i < m_agents.size(); i++)
 		delete m_agents[i];
 	m_agents.clear();
+	m_agentMap.clear();
 
 	delete m_fittestList; m_fittestList = NULL;
+	delete m_jobSystem; m_jobSystem = NULL;
 }
 
 void Simulation::Initialize(const SimulationParams& params)
 {
 	Simulation::PARAMS = params;
+	BrainGenome::InitializeLayout();
 
 	m_worldRenderer.LoadModels();
 	
 	m_worldAge			= 0;
 	m_agentCounter		= 1; // Start at 1, 0 is reserved as the NULL ID.
 	m_statistics		= SimulationStats();
+	for (int i = 0; i < NUM_GENE_STATS; i++)
+		m_geneStats[i].Reset();
+	m_profiler.Reset();
+	m_populationController.Reset();
 	m_fittestList		= new FittestList(Simulation::PARAMS.numFittest);
-	m_agentVisionPixels = new float[PARAMS.retinaResolution * 3 * PARAMS.maxAgents]; // 3 channels.
+	m_jobSystem			= new JobSystem(Simulation::PARAMS.numWorkerThreads);
+	m_visionAtlasWidth	= Math::Max(VISION_ATLAS_WIDTH, PARAMS.retinaResolution);
+	m_agentVisionPixels = new float[m_visionAtlasWidth * 3 * PARAMS.maxAgents]; // 3 channels.
 
 	// Setup OpenGL state.
 	glDepthMask(true);
     glEnable(GL_DEPTH_CLAMP);
+	if (GLEW_VERSION_3_0)
+		CreateVisionFramebuffer();
+
+	// Select the neuron activation function.
+	ActivationFunctionType activationFunction = ActivationFunction::Initialize(
+		PARAMS.activationFunction, PARAMS.maxActivationError);
+	if (activationFunction != PARAMS.activationFunction)
+	{
+		std::cout << "WARNING: " << ActivationFunction::GetName(PARAMS.activationFunction)
+			<< " activation function is not accurate enough, using "
+			<< ActivationFunction::GetName(activationFunction) << " instead" << std::endl;
+	}
+	std::cout << "Activation function: " << ActivationFunction::GetName(activationFunction)
+		<< " (max error = " << ActivationFunction::GetMaxError() << ")" << std::endl;
+	if (activationFunction != ACTIVATION_FUNCTION_EXACT)
+		Brain::ReportActivationFunctionDrift(activationFunction, 20, 500);
+
+	// Report the accuracy of compact synapses compared to 32-bit floats.
+	if (PARAMS.compactSynapses)
+		Brain::ReportSynapseFormatError(SYNAPSE_FORMAT_COMPACT, 20, 500);
+
+#ifdef _DEBUG
+	// Make sure brains still grow the same synapses as with the original
+	// neuron search.
+	Brain::CheckNearestFreeNeuron(10000);
+#endif
 		
 	//-----------------------------------------------------------------------------
 	// Initialize world.
 	
 	Random::SeedTime();
 
-	// Create initial food.
+	m_visionCache.Initialize(PARAMS.worldWidth, PARAMS.worldHeight,
+		PARAMS.visionCacheCellSize, m_worldRenderer.GetMaxObjectRadius());
+
+	// Place the food sites and grow the initial food.
+	m_food.Initialize(
+		Math::Max(PARAMS.numFoodSites, PARAMS.minFood),
+		PARAMS.numFoodPatches, PARAMS.foodPatchRadius,
+		PARAMS.worldWidth, PARAMS.worldHeight);
 	for (int i = 0; i < Simulation::PARAMS.initialFoodCount; i++)
 	{
-		Food* food = new Food();
-		food->Randomize();
-		food->SetPosition(Vector2f(
-			Random::NextFloat() * PARAMS.worldWidth,
-			Random::NextFloat() * PARAMS.worldHeight));
-		m_food.push_back(food);
+		m_food.RegrowRandomSite(Random::NextFloat(
+			FoodField::GetMinSize(), FoodField::GetMaxSize()));
 	}
 	
 	// Create initial agents with random genomes.
 	for (int i = 0; i < Simulation::PARAMS.initialNumAgents; i++)
 	{
-		Agent* agent = new Agent(this);
-		agent->GetGenome()->Randomize();
+		Agent* agent = RequestBirth(NULL, NULL);
 		agent->Birth(AgentCreation::CREATED_RANDOM);
-		agent->Grow();
 		agent->SetPosition(Vector2f(
 			Random::NextFloat() * PARAMS.worldWidth,
 			Random::NextFloat() * PARAMS.worldHeight));
-		m_agents.push_back(agent);
 	}
+
+	GrowBirthRequests();
+	PreBirthNewborns();
+	SampleStatistics();
+	m_statisticsSampled = true;
 }
 
 
@@ -80,33 +154,60 @@ void Simulation::Initialize(const SimulationParams& params)
 
 void Simulation::Update()
 {
+	UpdateWorld();
+	FinishUpdate();
+}
+
+void Simulation::UpdateWorld()
+{
+	// Adjust the population cap to the cost of the last tick, counting its
+	// vision as if it hadn't overlapped with the tick.
+	if (m_profiler.GetNumTicks() > 0)
+	{
+		m_populationController.Update(m_profiler.GetLastTickTime() +
+			m_visionTimes.submitTime + m_visionTimes.waitTime + m_visionTimes.readTime,
+			GetNumAgents());
+	}
+
 	m_worldAge++;
 
 	//PARAMS.worldWidth  = 1200 + Math::Min(m_worldAge / 800000.0f, 1.0f) * 2000;
 	//PARAMS.worldHeight = 1200 + Math::Min(m_worldAge / 800000.0f, 1.0f) * 2000;
 
+	m_profiler.BeginTick();
+
+	m_profiler.BeginPhase(TICK_PHASE_AGENTS);
+	if (PARAMS.spatialSortInterval > 0 && m_worldAge % PARAMS.spatialSortInterval == 0)
+		SortAgentsSpatially();
 	UpdateAgents();
+	m_profiler.EndPhase(TICK_PHASE_AGENTS);
+
+	m_profiler.BeginPhase(TICK_PHASE_STEADY_STATE_GA);
 	UpdateSteadyStateGA();
+	m_profiler.EndPhase(TICK_PHASE_STEADY_STATE_GA);
+
+	m_profiler.BeginPhase(TICK_PHASE_FOOD);
 	UpdateFood();
+	m_profiler.EndPhase(TICK_PHASE_FOOD);
+}
+
+void Simulation::FinishUpdate()
+{
+	m_profiler.BeginPhase(TICK_PHASE_PREBIRTH);
+	PreBirthNewborns();
+	m_profiler.EndPhase(TICK_PHASE_PREBIRTH);
+
+	m_profiler.EndTick();
+
+	m_statisticsSampled = (m_worldAge % Math::Max(1, PARAMS.statisticsInterval) == 0);
+	if (m_statisticsSampled)
+		SampleStatistics();
 }
 
 void Simulation::UpdateAgents()
 {
-	m_statistics.avgSize = 0.0f;
-	m_statistics.avgStrength = 0.0f;
-	m_statistics.avgFOV = 0.0f;
-	m_statistics.avgMaxSpeed = 0.0f;
-	m_statistics.avgGreenColor = 0.0f;
-	m_statistics.avgMutationRate = 0.0f;
-	m_statistics.avgNumCrossoverPoints = 0.0f;
-	m_statistics.avgLifeSpan = 0.0f;
-	m_statistics.avgBirthEnergyFraction = 0.0f;
-	m_statistics.avgNumRedNeurons = 0.0f;
-	m_statistics.avgNumGreenNeurons = 0.0f;
-	m_statistics.avgNumBlueNeurons = 0.0f;
-	m_statistics.avgNumInternalNeurGroups = 0.0f;
-	m_statistics.avgNumNeurons = 0.0f;
-	m_statistics.avgNumSynapses = 0.0f;
+	// Only the behavior of the agents is accumulated each tick. Their genetic
+	// traits are tracked as they are born and die (see SampleStatistics).
 	m_statistics.totalEnergy = 0.0f;
 	m_statistics.avgEnergyUsage = 0.0f;
 	m_statistics.avgEatAmount = 0.0f;
@@ -120,42 +221,17 @@ void Simulation::UpdateAgents()
 		Vector2f agentPos = agent->GetPosition();
 		
 		// Find nearby food to eat.
-		for (unsigned int j = 0; j < m_food.size(); j++)
+		if (agent->GetEatAmount() > 0.3f)
 		{
-			Food* food = m_food[j];
-			float distToFood = Vector2f::Dist(agentPos, food->GetPosition());
-			if (distToFood < agent->GetEatRadius() + food->GetRadius() && agent->GetEatAmount() > 0.3f)
+			m_food.ForEachSiteNear(agentPos, agent->GetEatRadius(), [&](int site)
 			{
-				agent->OnEat(m_food[j]->Eat(0.04f) * agent->GetEatAmount());
-
-				if (food->IsDepleted())
-				{
-					delete food;
-					food = NULL;
-					m_food.erase(m_food.begin() + j);
-					j--;
-				}
-			}
+				agent->OnEat(m_food.Eat(site, 0.04f) * agent->GetEatAmount());
+			});
 		}
 		
 		// Update the agent.
 		agent->Update();
 		
-		m_statistics.avgSize += agent->GetSize();
-		m_statistics.avgStrength += agent->GetStrength();
-		m_statistics.avgFOV += agent->GetFOV();
-		m_statistics.avgMaxSpeed += agent->GetGenome()->GetMaxSpeed();
-		m_statistics.avgGreenColor += agent->GetGenome()->GetGreenColoration();
-		m_statistics.avgMutationRate += agent->GetGenome()->GetMutationRate();
-		m_statistics.avgNumCrossoverPoints += (float) agent->GetGenome()->GetNumCrossoverPoints();
-		m_statistics.avgLifeSpan += (float) agent->GetLifeSpan();
-		m_statistics.avgBirthEnergyFraction += agent->GetBirthEnergyFraction();
-		m_statistics.avgNumRedNeurons += (float) agent->GetGenome()->GetNumRedNeurons();
-		m_statistics.avgNumGreenNeurons += (float) agent->GetGenome()->GetNumGreenNeurons();
-		m_statistics.avgNumBlueNeurons += (float) agent->GetGenome()->GetNumBlueNeurons();
-		m_statistics.avgNumInternalNeurGroups += (float) agent->GetGenome()->GetNumInternalNeuralGroups();
-		m_statistics.avgNumNeurons += (float) agent->GetNeuralNet()->GetDimensions().numNeurons;
-		m_statistics.avgNumSynapses += (float) agent->GetNeuralNet()->GetDimensions().numSynapses;
 		m_statistics.totalEnergy += agent->GetEnergy();
 		m_statistics.avgEnergyUsage += agent->GetEnergyUsage();
 		m_statistics.avgEatAmount += agent->GetEatAmount();
@@ -177,21 +253,6 @@ void Simulation::UpdateAgents()
 	}
 	
 	float avgDiv = 1.0f / (float) m_agents.size();
-	m_statistics.avgSize *= avgDiv;
-	m_statistics.avgStrength *= avgDiv;
-	m_statistics.avgFOV *= avgDiv;
-	m_statistics.avgMaxSpeed *= avgDiv;
-	m_statistics.avgGreenColor *= avgDiv;
-	m_statistics.avgMutationRate *= avgDiv;
-	m_statistics.avgNumCrossoverPoints *= avgDiv;
-	m_statistics.avgLifeSpan *= avgDiv;
-	m_statistics.avgBirthEnergyFraction *= avgDiv;
-	m_statistics.avgNumRedNeurons *= avgDiv;
-	m_statistics.avgNumGreenNeurons *= avgDiv;
-	m_statistics.avgNumBlueNeurons *= avgDiv;
-	m_statistics.avgNumInternalNeurGroups *= avgDiv;
-	m_statistics.avgNumNeurons *= avgDiv;
-	m_statistics.avgNumSynapses *= avgDiv;
 	m_statistics.avgEnergyUsage *= avgDiv;
 	m_statistics.avgEatAmount *= avgDiv;
 	m_statistics.avgMateAmount *= avgDiv;
@@ -221,31 +282,21 @@ void Simulation::UpdateAgents()
 				daddy->GetMateAmount() > mateThreshhold)// &&
 				//Random::NextFloat() < (mommy->GetMateAmount() * daddy->GetMateAmount()) * 0.001f)
 			{
-				Agent* child = Mate(mommy, daddy);
-				if (child != NULL)
-				{
-					child->SetPosition((mommy->GetPosition() + daddy->GetPosition()) * 0.5f);
-					m_agents.push_back(child);
-				}
+				Mate(mommy, daddy);
 				break;
 			}
 		}
 	}
+
+	// Grow the children that were conceived.
+	GrowBirthRequests();
 }
 
 void Simulation::UpdateFood()
 {
-	// TODO: Food patches.
-
-	// Spawn food at a constant rate.
-	if ((int) m_food.size() < Simulation::PARAMS.minFood && m_worldAge % 4 == 0)
-	{
-		Food* food = new Food();
-		food->SetPosition(Vector2f(
-			Random::NextFloat() * PARAMS.worldWidth,
-			Random::NextFloat() * PARAMS.worldHeight));
-		m_food.push_back(food);
-	}
+	// Regrow food at a constant rate, at a random depleted site.
+	if (m_food.GetNumActive() < m_populationController.GetFoodLevel() && m_worldAge % 4 == 0)
+		m_food.RegrowRandomSite(FoodField::GetMaxSize());
 }
 
 void Simulation::UpdateSteadyStateGA()
@@ -253,23 +304,20 @@ void Simulation::UpdateSteadyStateGA()
 	// Steady state GA for when the population is too small.
 	if (m_fittestList->GetSize() > 1)
 	{
-		while ((int) m_agents.size() < Simulation::PARAMS.minAgents)
+		int numAgentsNeeded = Simulation::PARAMS.minAgents - (int) m_agents.size();
+
+		for (int i = 0; i < numAgentsNeeded; i++)
 		{
-			Agent* child = new  Agent(this);
-			
-			int numAgentsCreated = m_statistics.numAgentsCreatedElite +
-								   m_statistics.numAgentsCreatedMate +
-								   m_statistics.numAgentsCreatedRandom;
+			Agent* child;
 			
 			if (Random::NextFloat() < 0.5f) // TODO: magic number
 			{
 				// Mate two agents.
 				int iParent, jParent;
 				PickParentsUsingTournament(m_fittestList->GetSize(), &iParent, &jParent);
-				child->GetGenome()->Crossover(
+				child = RequestBirth(
 					m_fittestList->GetByRank(iParent)->genome,
 					m_fittestList->GetByRank(jParent)->genome);
-				child->GetGenome()->Mutate();
 				m_statistics.numAgentsCreatedMate++;
 				child->Birth(AgentCreation::CREATED_MATE,
 					m_fittestList->GetByRank(iParent)->agentID,
@@ -278,7 +326,7 @@ void Simulation::UpdateSteadyStateGA()
 			else
 			{
 				// Create a random agent.
-				child->GetGenome()->Randomize();
+				child = RequestBirth(NULL, NULL);
 				m_statistics.numAgentsCreatedRandom++;
 				child->Birth(AgentCreation::CREATED_RANDOM);
 			}
@@ -287,13 +335,230 @@ void Simulation::UpdateSteadyStateGA()
 			//m_numAgentsCreatedElite++;
 			//child->Birth(AgentCreation::CREATED_ELITE, ...);
 
-			child->Grow();
 			child->SetPosition(Vector2f(
 				Random::NextFloat() * PARAMS.worldWidth,
 				Random::NextFloat() * PARAMS.worldHeight));
-			
-			m_agents.push_back(child);
 		}
+
+		GrowBirthRequests();
+	}
+}
+
+// Create a new agent whose genome will be created from the given parents (or
+// randomized if there are none). The agent is not added to the world until
+// GrowBirthRequests() is called.
+Agent* Simulation::RequestBirth(BrainGenome* parent1, BrainGenome* parent2, float energy)
+{
+	BirthRequest request;
+	request.child		= new Agent(this);
+	request.parents[0]	= parent1;
+	request.parents[1]	= parent2;
+	request.energy		= energy;
+
+	// Draw the seed here, so the results don't depend on the order in which
+	// the requests are carried out. rand() only gives 15 bits at a time.
+	request.seed = ((unsigned long) Random::NextInt() << 15) ^ (unsigned long) Random::NextInt();
+
+	m_birthRequests.push_back(request);
+	return request.child;
+}
+
+// Create the genomes and grow the bodies and brains of all requested births
+// in parallel, then add the new agents to the world in the order they were
+// requested.
+void Simulation::GrowBirthRequests()
+{
+	if (m_birthRequests.empty())
+		return;
+
+	m_jobSystem->ParallelFor((int) m_birthRequests.size(), [this](int i)
+	{
+		BirthRequest& request = m_birthRequests[i];
+		BrainGenome* genome = request.child->GetGenome();
+		RandomNumberGenerator rng(request.seed);
+
+		if (request.parents[0] != NULL && request.parents[1] != NULL)
+		{
+			genome->Crossover(request.parents[0], request.parents[1], rng);
+			genome->Mutate(rng);
+		}
+		else
+		{
+			genome->Randomize(rng);
+		}
+
+		request.child->Grow(rng);
+	});
+
+	for (unsigned int i = 0; i < m_birthRequests.size(); i++)
+	{
+		BirthRequest& request = m_birthRequests[i];
+		if (request.energy >= 0.0f)
+			request.child->SetEnergy(request.energy);
+		m_agents.push_back(request.child);
+		m_agentMap[request.child->GetID()] = request.child;
+		m_newborns.push_back(request.child);
+		AddAgentStatistics(request.child);
+	}
+
+	m_birthRequests.clear();
+}
+
+// Prebirth the brains of all agents created this tick, all at once. Each
+// brain uses its own random number generator, so they can be run in parallel.
+void Simulation::PreBirthNewborns()
+{
+	if (m_newborns.empty())
+		return;
+
+	m_jobSystem->ParallelFor((int) m_newborns.size(), [this](int i)
+	{
+		m_newborns[i]->PreBirth();
+	});
+
+	m_newborns.clear();
+}
+
+// Sort the agents by the Morton code of their positions, so that the agent
+// passes visit them in a spatially coherent order. Agents are referred to by
+// ID, so their indices can change. The sort is stable, so the order is
+// deterministic.
+void Simulation::SortAgentsSpatially()
+{
+	int numAgents = (int) m_agents.size();
+	m_agentSorter.Begin(numAgents, PARAMS.worldWidth, PARAMS.worldHeight);
+	for (int i = 0; i < numAgents; i++)
+	{
+		Vector2f pos = m_agents[i]->GetPosition();
+		m_agentSorter.SetPoint(i, pos.x, pos.y);
+	}
+
+	const std::vector<int>& order = m_agentSorter.Sort();
+	m_sortedAgents.resize(numAgents);
+	for (int i = 0; i < numAgents; i++)
+		m_sortedAgents[i] = m_agents[order[i]];
+	m_agents.swap(m_sortedAgents);
+}
+
+// Stands in for an agent in the spatial sort benchmark. Only the position
+// and energy are used, and the rest pads it out to about the size of an
+// agent, so that each one is on its own cache lines.
+struct BenchmarkAgent
+{
+	unsigned long	id;
+	Vector2f		position;
+	float			energy;
+	char			padding[240];
+};
+
+// Time one eat query per agent, the way the agent pass does, first with the
+// food sites and agents in the order they were placed, then with both in
+// Morton order. As in SortAgentsSpatially, only the list of agent pointers
+// is sorted, and the agents stay where they were allocated. Then time
+// looking agents up by ID with a linear scan and with a hash map. Each time
+// is the best of several runs.
+void Simulation::ReportSpatialSortBenchmark(int numSites, int numAgents)
+{
+	const int numRepeats = 7;
+	const int numLookups = 1000;
+	const float eatRadius = 13.0f;
+
+	// Keep the default density of food sites (480 sites in 1300x1300).
+	float worldSize = Math::Sqrt(numSites * (1300.0f * 1300.0f / 480.0f));
+
+	// Place the same sites in both fields, and grow food at all of them.
+	FoodField food[2];
+	for (int k = 0; k < 2; k++)
+	{
+		Random::Seed(1);
+		food[k].Initialize(numSites, 0, 0.0f, worldSize, worldSize, (k == 1));
+		while (food[k].RegrowRandomSite(FoodField::GetMaxSize()))
+		{
+		}
+	}
+
+	std::vector<BenchmarkAgent*> agents[2];
+	std::unordered_map<unsigned long, BenchmarkAgent*> benchmarkAgentMap;
+	MortonSorter sorter;
+	sorter.Begin(numAgents, worldSize, worldSize);
+	for (int i = 0; i < numAgents; i++)
+	{
+		BenchmarkAgent* agent = new BenchmarkAgent();
+		agent->id = (unsigned long) i;
+		agent->position.x = Random::NextFloat() * worldSize;
+		agent->position.y = Random::NextFloat() * worldSize;
+		agent->energy = 0.0f;
+		agents[0].push_back(agent);
+		benchmarkAgentMap[agent->id] = agent;
+		sorter.SetPoint(i, agent->position.x, agent->position.y);
+	}
+	const std::vector<int>& order = sorter.Sort();
+	for (int i = 0; i < numAgents; i++)
+		agents[1].push_back(agents[0][order[i]]);
+
+	double eatTimes[2];
+	for (int k = 0; k < 2; k++)
+	{
+		for (int r = 0; r < numRepeats; r++)
+		{
+			double startTime = Time::GetTime();
+			for (int i = 0; i < numAgents; i++)
+			{
+				BenchmarkAgent* agent = agents[k][i];
+				food[k].ForEachSiteNear(agent->position, eatRadius, [&](int site)
+				{
+					agent->energy += food[k].GetSize(site);
+				});
+			}
+			double time = Time::GetTime() - startTime;
+			if (r == 0 || time < eatTimes[k])
+				eatTimes[k] = time;
+		}
+	}
+
+	// Look up random agents in the sorted list, so the IDs are out of order.
+	std::vector<unsigned long> ids(numLookups);
+	for (int i = 0; i < numLookups; i++)
+		ids[i] = (unsigned long) Random::NextInt(0, Math::Max(1, numAgents));
+
+	double lookupTimes[2];
+	for (int k = 0; k < 2; k++)
+	{
+		for (int r = 0; r < numRepeats && numAgents > 0; r++)
+		{
+			double startTime = Time::GetTime();
+			for (int i = 0; i < numLookups; i++)
+			{
+				BenchmarkAgent* agent = NULL;
+				if (k == 0)
+				{
+					for (int j = 0; j < numAgents && agent == NULL; j++)
+					{
+						if (agents[1][j]->id == ids[i])
+							agent = agents[1][j];
+					}
+				}
+				else
+					agent = benchmarkAgentMap[ids[i]];
+				agent->energy += 1.0f;
+			}
+			double time = Time::GetTime() - startTime;
+			if (r == 0 || time < lookupTimes[k])
+				lookupTimes[k] = time;
+		}
+	}
+
+	for (int i = 0; i < numAgents; i++)
+		delete agents[0][i];
+
+	std::cout << "Spatial sort benchmark, " << numSites << " food sites, "
+		<< numAgents << " agents (best of " << numRepeats << "):" << std::endl;
+	std::cout << "  eat query: " << (eatTimes[0] * 1000.0) << " ms unsorted, "
+		<< (eatTimes[1] * 1000.0) << " ms sorted" << std::endl;
+	if (numAgents > 0)
+	{
+		std::cout << "  " << numLookups << " lookups by ID: " << (lookupTimes[0] * 1000.0)
+			<< " ms by scan, " << (lookupTimes[1] * 1000.0) << " ms by map" << std::endl;
 	}
 }
 
@@ -328,7 +593,7 @@ void Simulation::PickParentsUsingTournament(int numInPool, int* iParent, int* jP
 
 Agent* Simulation::Mate(Agent* mommy, Agent* daddy)
 {
-	if ((int) m_agents.size() + 1 > Simulation::PARAMS.maxAgents)
+	if ((int) (m_agents.size() + m_birthRequests.size()) + 1 > m_populationController.GetMaxAgents())
 	{
 		m_statistics.numBirthsDenied++;
 		mommy->MateDelay();
@@ -348,15 +613,9 @@ Agent* Simulation::Mate(Agent* mommy, Agent* daddy)
 	mommy->AddEnergy(-mommyEnergy);
 	daddy->AddEnergy(-daddyEnergy);
 
-	// Create the child.
-	Agent* child = new Agent(this);
-	child->GetGenome()->Crossover(
-		mommy->GetGenome(),
-		daddy->GetGenome());
-	child->GetGenome()->Mutate();
+	// Request the child, which will be grown after all agents have mated.
+	Agent* child = RequestBirth(mommy->GetGenome(), daddy->GetGenome(), childEnergy);
 	child->Birth(AgentCreation::BORN, mommy->GetID(), daddy->GetID());
-	child->Grow();
-	child->SetEnergy(childEnergy);
 	child->SetPosition((mommy->GetPosition() + daddy->GetPosition()) * 0.5f);
 	
 	mommy->OnMate();
@@ -372,6 +631,10 @@ void Simulation::Kill(Agent*& agent)
 	agent->SetHeuristicFitness(agent->GetHeuristicFitness() + (agent->GetAge() * Simulation::PARAMS.ageFitnessParam));
 	agent->SetHeuristicFitness(agent->GetHeuristicFitness() + (agent->GetEnergy() * Simulation::PARAMS.energyFitnessParam));
 
+	// Remove the agent's statistics before its genome is swapped into the
+	// fittest list.
+	RemoveAgentStatistics(agent);
+	m_agentMap.erase(agent->GetID());
 	m_fittestList->Update(agent, agent->GetHeuristicFitness());
 
 	delete agent;
@@ -379,6 +642,107 @@ void Simulation::Kill(Agent*& agent)
 }
 
 
+//-----------------------------------------------------------------------------
+// Statistics.
+//-----------------------------------------------------------------------------
+
+// Get the values of an agent's genetic traits, indexed by GeneStatistic.
+void Simulation::GetGeneStatisticValues(Agent* agent, float* values)
+{
+	BrainGenome* genome = agent->GetGenome();
+	NeuronModel* neuralNet = agent->GetNeuralNet();
+
+	values[GENE_STAT_SIZE]						= agent->GetSize();
+	values[GENE_STAT_STRENGTH]					= agent->GetStrength();
+	values[GENE_STAT_FOV]						= agent->GetFOV();
+	values[GENE_STAT_MAX_SPEED]					= genome->GetMaxSpeed();
+	values[GENE_STAT_GREEN_COLOR]				= genome->GetGreenColoration();
+	values[GENE_STAT_MUTATION_RATE]				= genome->GetMutationRate();
+	values[GENE_STAT_NUM_CROSSOVER_POINTS]		= (float) genome->GetNumCrossoverPoints();
+	values[GENE_STAT_LIFE_SPAN]					= (float) agent->GetLifeSpan();
+	values[GENE_STAT_BIRTH_ENERGY_FRACTION]		= agent->GetBirthEnergyFraction();
+	values[GENE_STAT_NUM_RED_NEURONS]			= (float) genome->GetNumRedNeurons();
+	values[GENE_STAT_NUM_GREEN_NEURONS]			= (float) genome->GetNumGreenNeurons();
+	values[GENE_STAT_NUM_BLUE_NEURONS]			= (float) genome->GetNumBlueNeurons();
+	values[GENE_STAT_NUM_INTERNAL_NEUR_GROUPS]	= (float) genome->GetNumInternalNeuralGroups();
+	values[GENE_STAT_NUM_NEURONS]				= (float) neuralNet->GetDimensions().numNeurons;
+	values[GENE_STAT_NUM_SYNAPSES]				= (float) neuralNet->GetDimensions().numSynapses;
+	values[GENE_STAT_LEARNING_SYNAPSE_FRACTION]	= neuralNet->GetLearningSynapseFraction();
+}
+
+void Simulation::AddAgentStatistics(Agent* agent)
+{
+	float values[NUM_GENE_STATS];
+	GetGeneStatisticValues(agent, values);
+	for (int i = 0; i < NUM_GENE_STATS; i++)
+		m_geneStats[i].Add(values[i]);
+}
+
+void Simulation::RemoveAgentStatistics(Agent* agent)
+{
+	float values[NUM_GENE_STATS];
+	GetGeneStatisticValues(agent, values);
+	for (int i = 0; i < NUM_GENE_STATS; i++)
+		m_geneStats[i].Remove(values[i]);
+}
+
+// Copy the gene statistics into the simulation stats. Ranges which were
+// invalidated by the death of an agent with an extreme value are recomputed
+// here, rather than every time an agent dies.
+void Simulation::SampleStatistics()
+{
+	bool isRangeValid = true;
+	for (int i = 0; i < NUM_GENE_STATS; i++)
+		isRangeValid = isRangeValid && m_geneStats[i].IsRangeValid();
+
+	if (!isRangeValid && !m_agents.empty())
+	{
+		float values[NUM_GENE_STATS];
+		float minValues[NUM_GENE_STATS];
+		float maxValues[NUM_GENE_STATS];
+		GetGeneStatisticValues(m_agents[0], minValues);
+		for (int i = 0; i < NUM_GENE_STATS; i++)
+			maxValues[i] = minValues[i];
+
+		for (unsigned int j = 1; j < m_agents.size(); j++)
+		{
+			GetGeneStatisticValues(m_agents[j], values);
+			for (int i = 0; i < NUM_GENE_STATS; i++)
+			{
+				minValues[i] = Math::Min(minValues[i], values[i]);
+				maxValues[i] = Math::Max(maxValues[i], values[i]);
+			}
+		}
+
+		for (int i = 0; i < NUM_GENE_STATS; i++)
+			m_geneStats[i].SetRange(minValues[i], maxValues[i]);
+	}
+
+	m_statistics.avgSize					= m_geneStats[GENE_STAT_SIZE].GetMean();
+	m_statistics.avgStrength				= m_geneStats[GENE_STAT_STRENGTH].GetMean();
+	m_statistics.avgFOV						= m_geneStats[GENE_STAT_FOV].GetMean();
+	m_statistics.avgMaxSpeed				= m_geneStats[GENE_STAT_MAX_SPEED].GetMean();
+	m_statistics.avgGreenColor				= m_geneStats[GENE_STAT_GREEN_COLOR].GetMean();
+	m_statistics.avgMutationRate			= m_geneStats[GENE_STAT_MUTATION_RATE].GetMean();
+	m_statistics.avgNumCrossoverPoints		= m_geneStats[GENE_STAT_NUM_CROSSOVER_POINTS].GetMean();
+	m_statistics.avgLifeSpan				= m_geneStats[GENE_STAT_LIFE_SPAN].GetMean();
+	m_statistics.avgBirthEnergyFraction		= m_geneStats[GENE_STAT_BIRTH_ENERGY_FRACTION].GetMean();
+	m_statistics.avgNumRedNeurons			= m_geneStats[GENE_STAT_NUM_RED_NEURONS].GetMean();
+	m_statistics.avgNumGreenNeurons			= m_geneStats[GENE_STAT_NUM_GREEN_NEURONS].GetMean();
+	m_statistics.avgNumBlueNeurons			= m_geneStats[GENE_STAT_NUM_BLUE_NEURONS].GetMean();
+	m_statistics.avgNumInternalNeurGroups	= m_geneStats[GENE_STAT_NUM_INTERNAL_NEUR_GROUPS].GetMean();
+	m_statistics.avgNumNeurons				= m_geneStats[GENE_STAT_NUM_NEURONS].GetMean();
+	m_statistics.avgNumSynapses				= m_geneStats[GENE_STAT_NUM_SYNAPSES].GetMean();
+	m_statistics.avgLearningSynapseFraction	= m_geneStats[GENE_STAT_LEARNING_SYNAPSE_FRACTION].GetMean();
+
+	// Summarize the fitness of the fittest list. The list keeps these as it
+	// changes, so the ranking isn't sorted just to sample them.
+	m_statistics.worstFitness	= m_fittestList->GetWorstFitness();
+	m_statistics.avgFitness		= m_fittestList->GetAverageFitness();
+	m_statistics.bestFitness	= m_fittestList->GetBestFitness();
+}
+
+
 //-----------------------------------------------------------------------------
 // Agent Vision.
 //-----------------------------------------------------------------------------
@@ -386,17 +750,62 @@ void Simulation::Kill(Agent*& agent)
 // Render the vision of all agents.
 void Simulation::RenderAgentsVision(Graphics* g)
 {
-	// Render each agent's vision.
+	SubmitAgentsVision(g);
+	ApplyAgentsVision();
+}
+
+void Simulation::SubmitAgentsVision(Graphics* g)
+{
+	double startTime = Time::GetTime();
+
+	// Reading back into a pixel buffer lets the GPU finish the vision in the
+	// background. Without sync objects, fall back to reading the pixels
+	// straight away.
+	bool async = (GLEW_VERSION_3_3 != GL_FALSE);
+	if (async && m_visionPixelBuffer == 0)
+	{
+		glGenBuffers(1, &m_visionPixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_visionPixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER,
+			m_visionAtlasWidth * 3 * PARAMS.maxAgents * sizeof(float),
+			NULL, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glGenQueries(1, &m_visionTimerQuery);
+	}
+	if (m_visionFence != NULL)
+	{
+		glDeleteSync(m_visionFence);
+		m_visionFence = NULL;
+	}
+
+	// Render into the vision framebuffer, so the vision doesn't depend on
+	// the window being visible.
+	GLint prevFramebuffer = 0;
+	if (m_visionFramebuffer != 0)
+	{
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_visionFramebuffer);
+	}
+
+	if (async)
+		glBeginQuery(GL_TIME_ELAPSED, m_visionTimerQuery);
+
+	m_visionCache.Update(m_agents, m_food, VISION_FAR_PLANE);
+	PackVisionAtlas();
+
+	// Render the vision of each agent which can't reuse its last vision.
 	for (unsigned int i = 0; i < m_agents.size(); i++)
 	{
 		Agent* agent = m_agents[i];
+		if (m_visionViewports[i].width == 0)
+			continue;
 
 		float fovY = 0.01f; // TODO: magic number: agent FOV-Y.
 
 		// Setup the camera for the agent.
 		Camera agentCam;
 		agentCam.projection = Matrix4f::CreatePerspectiveXY(
-			agent->GetFOV(), fovY, 0.1f, 1000.0f);
+			agent->GetFOV(), fovY, 0.1f, VISION_FAR_PLANE);
 		agentCam.position.SetXY(agent->GetPosition());
 		agentCam.position.z = 3.0f;
 		agentCam.rotation = Quaternion::IDENTITY;
@@ -405,22 +814,304 @@ void Simulation::RenderAgentsVision(Graphics* g)
 		agentCam.rotation.Rotate(Vector3f::UNITZ, agent->GetDirection());
 
 		// Render the world from the agent's point-of-view.
-		Viewport vp(0, i, Simulation::PARAMS.retinaResolution, 1);
-		g->SetViewport(vp, true, false);
+		g->SetViewport(m_visionViewports[i], true, false);
 		m_worldRenderer.RenderWorld(g, &agentCam, agent);
 	}
 			
-	// Read the pixels that were rendered.
-	// FIXME: Undefined behavior when window is minimized.
-	Viewport vp(0, 0, Simulation::PARAMS.retinaResolution, (int) m_agents.size());
+	// Read the rows of the atlas that were rendered. Without a vision
+	// framebuffer, the pixels are undefined when the window is minimized.
+	m_numVisionAgents = (int) m_agents.size();
+	Viewport vp(0, 0, m_visionAtlasWidth, m_visionAtlasHeight);
 	g->SetViewport(vp, true, false);
-	glReadPixels(vp.x, vp.y, vp.width, vp.height, GL_RGB, GL_FLOAT, m_agentVisionPixels);
+	if (m_visionFramebuffer != 0)
+	{
+		// Resolve the multisampled vision into a normal framebuffer.
+		glDisable(GL_SCISSOR_TEST);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_visionResolveFramebuffer);
+		glBlitFramebuffer(vp.x, vp.y, vp.x + vp.width, vp.y + vp.height,
+						  vp.x, vp.y, vp.x + vp.width, vp.y + vp.height,
+						  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_visionResolveFramebuffer);
+	}
+	if (async)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_visionPixelBuffer);
+		glReadPixels(vp.x, vp.y, vp.width, vp.height, GL_RGB, GL_FLOAT, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_visionFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+	}
+	else
+	{
+		glReadPixels(vp.x, vp.y, vp.width, vp.height, GL_RGB, GL_FLOAT, m_agentVisionPixels);
+	}
+
+	if (m_visionFramebuffer != 0)
+		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) prevFramebuffer);
+
+	m_visionTimes.submitTime = Time::GetTime() - startTime;
+}
+
+// Pack each agent's vision strip into the atlas, filling the rows from left
+// to right. An agent renders only as many pixels as its retina needs, so the
+// atlas holds several agents per row, and fewer rows have to be rendered and
+// read back. Agents which can reuse their last vision are left out.
+void Simulation::PackVisionAtlas()
+{
+	m_visionViewports.resize(m_agents.size());
+	int x = 0;
+	int y = 0;
+	bool isEmpty = true;
+	for (unsigned int i = 0; i < m_agents.size(); i++)
+	{
+		if (!m_visionCache.NeedsVision(i))
+		{
+			m_visionViewports[i] = Viewport(0, 0, 0, 0);
+			continue;
+		}
+
+		int width = m_agents[i]->GetRetina().GetResolution();
+		if (x + width > m_visionAtlasWidth)
+		{
+			x = 0;
+			y++;
+		}
+		m_visionViewports[i] = Viewport(x, y, width, 1);
+		x += width;
+		isEmpty = false;
+	}
+	m_visionAtlasHeight = (isEmpty ? 0 : y + 1);
+}
+
+// Create a framebuffer for the vision atlas, with room for a row per agent.
+// It is multisampled like the window, then resolved into a second framebuffer
+// which the pixels are read from.
+bool Simulation::CreateVisionFramebuffer()
+{
+	int width = m_visionAtlasWidth;
+	int height = PARAMS.maxAgents;
+
+	glGenRenderbuffers(3, m_visionRenderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_visionRenderbuffers[0]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_visionRenderbuffers[1]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_visionRenderbuffers[2]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLint prevFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFramebuffer);
+
+	glGenFramebuffers(1, &m_visionFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_visionFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_visionRenderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_visionRenderbuffers[1]);
+	bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+	glGenFramebuffers(1, &m_visionResolveFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_visionResolveFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_visionRenderbuffers[2]);
+	complete = complete && (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) prevFramebuffer);
+
+	// Fall back to rendering into the window.
+	if (!complete)
+	{
+		std::cout << "WARNING: Couldn't create the vision framebuffer" << std::endl;
+		glDeleteFramebuffers(1, &m_visionFramebuffer);
+		glDeleteFramebuffers(1, &m_visionResolveFramebuffer);
+		glDeleteRenderbuffers(3, m_visionRenderbuffers);
+		m_visionFramebuffer = 0;
+		m_visionResolveFramebuffer = 0;
+	}
+	return complete;
+}
+
+void Simulation::ApplyAgentsVision()
+{
+	// Nothing to do if the pixel buffer has no readback waiting.
+	if (m_visionPixelBuffer != 0 && m_visionFence == NULL)
+		return;
+
+	const float* pixels = m_agentVisionPixels;
+	m_visionTimes.waitTime = 0.0;
+	m_visionTimes.gpuTime = 0.0;
+
+	// Wait for the readback to finish.
+	if (m_visionFence != NULL)
+	{
+		double startTime = Time::GetTime();
+		GLenum result;
+		do
+		{
+			result = glClientWaitSync(m_visionFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		while (result == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(m_visionFence);
+		m_visionFence = NULL;
+		m_visionTimes.waitTime = Time::GetTime() - startTime;
+
+		GLuint64 gpuTime = 0;
+		glGetQueryObjectui64v(m_visionTimerQuery, GL_QUERY_RESULT, &gpuTime);
+		m_visionTimes.gpuTime = gpuTime * 1.0e-9;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_visionPixelBuffer);
+		pixels = (const float*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	}
 	
 	// Update the agents' visions with the pixel data.
+	double startTime = Time::GetTime();
+	for (int i = 0; i < m_numVisionAgents && pixels != NULL; i++)
+	{
+		const Viewport& vp = m_visionViewports[i];
+		if (vp.width == 0)
+			continue;
+		int offset = ((vp.y * m_visionAtlasWidth) + vp.x) * 3;
+		m_agents[i]->UpdateVision(pixels + offset, vp.width);
+	}
+	m_visionTimes.readTime = Time::GetTime() - startTime;
+
+	if (pixels != m_agentVisionPixels)
+	{
+		if (pixels != NULL)
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
+
+void Simulation::WriteRenderSnapshot(RenderSnapshot& snapshot, unsigned long selectedAgentID)
+{
+	snapshot.worldAge	= m_worldAge;
+	snapshot.numAgents	= GetNumAgents();
+	snapshot.maxAgents	= m_populationController.GetMaxAgents();
+	snapshot.numFood	= GetNumFood();
+	snapshot.stats		= m_statistics;
+	snapshot.statisticsSampled = m_statisticsSampled;
+	snapshot.tickTime	= m_profiler.GetTickTime();
+	for (int i = 0; i < NUM_TICK_PHASES; i++)
+		snapshot.phaseTimes[i] = m_profiler.GetPhaseTime((TickPhase) i);
+
+	// Food.
+	snapshot.food.clear();
+	for (int i = 0; i < m_food.GetNumSites(); i++)
+	{
+		if (!m_food.IsActive(i))
+			continue;
+		FoodSnapshot food;
+		food.position	= m_food.GetPosition(i);
+		food.size		= m_food.GetSize(i);
+		food.radius		= m_food.GetRadius(i);
+		snapshot.food.push_back(food);
+	}
+
+	// Agents.
+	snapshot.agents.resize(m_agents.size());
 	for (unsigned int i = 0; i < m_agents.size(); i++)
 	{
-		int offset = i * 3 * vp.width;
-		m_agents[i]->UpdateVision(m_agentVisionPixels + offset, vp.width);
+		Agent* agent = m_agents[i];
+		AgentSnapshot& agentSnapshot = snapshot.agents[i];
+
+		agentSnapshot.id			= agent->GetID();
+		agentSnapshot.position		= agent->GetPosition();
+		agentSnapshot.direction		= agent->GetDirection();
+		agentSnapshot.size			= agent->GetSize();
+		agentSnapshot.fov			= agent->GetFOV();
+		agentSnapshot.eatRadius		= agent->GetEatRadius();
+		agentSnapshot.mateRadius	= agent->GetMateRadius();
+		agentSnapshot.fightRadius	= agent->GetFightRadius();
+		agentSnapshot.color			= Color(Vector3f(
+			agent->GetFightAmount(),
+			agent->GetGenome()->GetGreenColoration(),
+			agent->GetMateAmount()));
+
+		Retina& retina = agent->GetRetina();
+		for (int j = 0; j < SNAPSHOT_SIGHT_SAMPLES; j++)
+		{
+			Vector3f color = Vector3f::ZERO;
+			for (int c = 0; c < retina.GetNumChannels() && c < 3; c++)
+			{
+				int neuronIndex = (int) ((j / (float) SNAPSHOT_SIGHT_SAMPLES) * retina.GetNumNeurons(c));
+				color[c] = retina.GetSightValue(c, neuronIndex);
+			}
+			agentSnapshot.sight[j] = color;
+		}
+	}
+
+	// The selected agent's details and brain.
+	SelectedAgentSnapshot& selected = snapshot.selectedAgent;
+	Agent* agent = (selectedAgentID != 0 ? GetAgent(selectedAgentID) : NULL);
+	if (agent == NULL)
+	{
+		selected.id = 0;
+		return;
+	}
+
+	BrainGenome* genome = agent->GetGenome();
+	NeuronModel* neuralNet = agent->GetNeuralNet();
+
+	selected.id						= agent->GetID();
+	selected.age					= agent->GetAge();
+	selected.lifespan				= agent->GetLifeSpan();
+	selected.energy					= agent->GetEnergy();
+	selected.maxEnergy				= agent->GetMaxEnergy();
+	selected.fitness				= agent->GetHeuristicFitness();
+	selected.moveSpeed				= agent->GetMoveSpeed();
+	selected.maxSpeed				= genome->GetMaxSpeed();
+	selected.turnSpeed				= agent->GetTurnSpeed();
+	selected.mateAmount				= agent->GetMateAmount();
+	selected.fightAmount			= agent->GetFightAmount();
+	selected.eatAmount				= agent->GetEatAmount();
+	selected.numFoodEaten			= agent->GetNumFoodEaten();
+	selected.numChildren			= agent->GetNumChildren();
+	selected.size					= agent->GetSize();
+	selected.strength				= agent->GetStrength();
+	selected.fov					= agent->GetFOV();
+	selected.greenColoration		= genome->GetGreenColoration();
+	selected.mutationRate			= genome->GetMutationRate();
+	selected.numCrossoverPoints		= genome->GetNumCrossoverPoints();
+	selected.genomeLifespan			= genome->GetLifespan();
+	selected.birthEnergyFraction	= genome->GetBirthEnergyFraction();
+	selected.numRedNeurons			= genome->GetNumRedNeurons();
+	selected.numGreenNeurons		= genome->GetNumGreenNeurons();
+	selected.numBlueNeurons			= genome->GetNumBlueNeurons();
+	selected.numInternalGroups		= genome->GetNumInternalNeuralGroups();
+
+	Retina& retina = agent->GetRetina();
+	for (int c = 0; c < 3; c++)
+	{
+		selected.sight[c].clear();
+		if (c >= retina.GetNumChannels())
+			continue;
+		for (int i = 0; i < retina.GetNumNeurons(c); i++)
+			selected.sight[c].push_back(retina.GetSightValue(c, i));
+	}
+
+	const NeuronModel::Dimensions& dims = neuralNet->GetDimensions();
+	selected.brainDimensions			= dims;
+	selected.learningSynapseFraction	= neuralNet->GetLearningSynapseFraction();
+	selected.neurons.resize(dims.numNeurons);
+	selected.activations.resize(dims.numNeurons);
+	selected.prevActivations.resize(dims.numNeurons);
+	for (int i = 0; i < dims.numNeurons; i++)
+	{
+		selected.neurons[i]			= neuralNet->GetNeuron(i);
+		selected.activations[i]		= neuralNet->GetNeuronActivation(i);
+		selected.prevActivations[i]	= neuralNet->GetNeuronActivationPrev(i);
+	}
+	selected.synapses.resize(dims.numSynapses);
+	for (long i = 0; i < dims.numSynapses; i++)
+		selected.synapses[i] = neuralNet->GetSynapse(i);
+
+	selected.internalGroupSizes.clear();
+	int numIOGroups = PARAMS.numInputNeurGroups + PARAMS.numOutputNeurGroups;
+	for (int i = numIOGroups; i < agent->GetBrain()->GetNumNeuralGroups(); i++)
+	{
+		selected.internalGroupSizes.push_back(
+			genome->GetNeuronCount(NEURON_TYPE_EXCITATORY, i) +
+			genome->GetNeuronCount(NEURON_TYPE_INHIBITORY, i));
 	}
 }
 
@@ -428,12 +1119,7 @@ void Simulation::RenderAgentsVision(Graphics* g)
 
 Agent* Simulation::GetAgent(unsigned long agentID)
 {
-	for (auto it = agents_begin(); it != agents_end(); ++it)
-	{
-		Agent* agent = *it;
-		if (agent->GetID() == agentID)
-			return agent;
-	}
-	return NULL;
+	agent_map::iterator it = m_agentMap.find(agentID);
+	return (it != m_agentMap.end() ? it->second : NULL);
 }
 
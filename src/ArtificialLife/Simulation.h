@@ -9,14 +9,122 @@
 #include <AppLib/math/Quaternion.h>
 #include <ArtificialLife/brain/NeuronModel.h>
 #include <ArtificialLife/agent/Agent.h>
-#include <ArtificialLife/food/Food.h>
+#include <ArtificialLife/food/FoodField.h>
 #include <ArtificialLife/Camera.h>
+#include <ArtificialLife/TickProfiler.h>
 #include <ArtificialLife/FittestList.h>
 #include <ArtificialLife/SimulationParams.h>
 #include <ArtificialLife/WorldRenderer.h>
 #include <ArtificialLife/ReplayRecorder.h>
+#include <ArtificialLife/VisionCache.h>
+#include <ArtificialLife/PopulationController.h>
+#include <AppLib/util/Morton.h>
+#include <AppLib/util/JobSystem.h>
 #include <vector>
+#include <unordered_map>
 
+struct RenderSnapshot;
+
+
+// Traits of the agents which are fixed at birth. Their statistics are kept
+// up to date as agents are born and die.
+enum GeneStatistic
+{
+	GENE_STAT_SIZE = 0,
+	GENE_STAT_STRENGTH,
+	GENE_STAT_FOV,
+	GENE_STAT_MAX_SPEED,
+	GENE_STAT_GREEN_COLOR,
+	GENE_STAT_MUTATION_RATE,
+	GENE_STAT_NUM_CROSSOVER_POINTS,
+	GENE_STAT_LIFE_SPAN,
+	GENE_STAT_BIRTH_ENERGY_FRACTION,
+	GENE_STAT_NUM_RED_NEURONS,
+	GENE_STAT_NUM_GREEN_NEURONS,
+	GENE_STAT_NUM_BLUE_NEURONS,
+	GENE_STAT_NUM_INTERNAL_NEUR_GROUPS,
+	GENE_STAT_NUM_NEURONS,
+	GENE_STAT_NUM_SYNAPSES,
+	GENE_STAT_LEARNING_SYNAPSE_FRACTION,
+
+	NUM_GENE_STATS,
+};
+
+
+// Running mean, variance and range of a set of values which can be added
+// and removed. When an extreme value is removed, the range becomes invalid
+// until it is set again from the remaining values.
+class Statistic
+{
+public:
+	Statistic() { Reset(); }
+
+	void Reset()
+	{
+		m_count			= 0;
+		m_sum			= 0.0;
+		m_sumSquares	= 0.0;
+		m_min			= 0.0f;
+		m_max			= 0.0f;
+		m_isRangeValid	= true;
+	}
+
+	void Add(float value)
+	{
+		if (m_count == 0)
+		{
+			m_min = value;
+			m_max = value;
+			m_isRangeValid = true;
+		}
+		else if (value < m_min)
+			m_min = value;
+		else if (value > m_max)
+			m_max = value;
+		m_count++;
+		m_sum += value;
+		m_sumSquares += (double) value * value;
+	}
+
+	void Remove(float value)
+	{
+		m_count--;
+		m_sum -= value;
+		m_sumSquares -= (double) value * value;
+		if (value <= m_min || value >= m_max)
+			m_isRangeValid = false;
+	}
+
+	void SetRange(float minValue, float maxValue)
+	{
+		m_min = minValue;
+		m_max = maxValue;
+		m_isRangeValid = true;
+	}
+
+	int		GetCount()		const { return m_count; }
+	float	GetMean()		const { return (m_count > 0 ? (float) (m_sum / m_count) : 0.0f); }
+	float	GetMin()		const { return m_min; }
+	float	GetMax()		const { return m_max; }
+	bool	IsRangeValid()	const { return m_isRangeValid; }
+
+	float GetVariance() const
+	{
+		if (m_count == 0)
+			return 0.0f;
+		double mean = m_sum / m_count;
+		double variance = (m_sumSquares / m_count) - (mean * mean);
+		return (variance > 0.0 ? (float) variance : 0.0f);
+	}
+
+private:
+	int		m_count;
+	double	m_sum;
+	double	m_sumSquares;
+	float	m_min;
+	float	m_max;
+	bool	m_isRangeValid;
+};
 
 
 struct SimulationStats
@@ -45,6 +153,7 @@ struct SimulationStats
 	float avgNumInternalNeurGroups;
 	float avgNumNeurons;
 	float avgNumSynapses;
+	float avgLearningSynapseFraction;
 	float avgEatAmount;
 	float avgMateAmount;
 	float avgFightAmount;
@@ -65,15 +174,46 @@ struct SimulationStats
 		, numAgentsCreatedMate(0)
 		, numAgentsCreatedRandom(0)
 		, numBirthsDenied(0)
+		, worstFitness(0.0f)
+		, avgFitness(0.0f)
+		, bestFitness(0.0f)
+	{}
+};
+
+
+// How long the stages of the last agent vision pass took, in seconds.
+struct VisionTimes
+{
+	double submitTime;	// Issuing the draw calls and the pixel readback.
+	double gpuTime;		// Rendering on the GPU.
+	double waitTime;	// Blocked waiting for the readback to finish.
+	double readTime;	// Copying the pixels into the agents' retinas.
+
+	VisionTimes()
+		: submitTime(0.0)
+		, gpuTime(0.0)
+		, waitTime(0.0)
+		, readTime(0.0)
 	{}
 };
 
 
+// A new agent waiting to have its genome created and its body and brain
+// grown. Requests are carried out together in GrowBirthRequests().
+struct BirthRequest
+{
+	Agent*			child;
+	BrainGenome*	parents[2];	// NULL for a random genome.
+	unsigned long	seed;		// Seed for the genome operations and growth.
+	float			energy;		// Negative to keep the child's default energy.
+};
+
+
 class Simulation
 {
 public:
-	typedef std::vector<Food*> food_list;
 	typedef std::vector<Agent*> agent_list;
+	typedef std::unordered_map<unsigned long, Agent*> agent_map;
 
 public:
 	Simulation();
@@ -81,20 +221,50 @@ public:
 	
 	void Initialize(const SimulationParams& params);
 	void Update();
+
+	// Measure what sorting the food sites and agents in Morton order, and
+	// looking agents up in the agent map, gain over leaving them unsorted
+	// and scanning for them. This doesn't need the simulation to be
+	// initialized.
+	static void ReportSpatialSortBenchmark(int numSites, int numAgents);
 	void RenderAgentsVision(Graphics* g);
+
+	// A tick can be run in two parts. UpdateWorld() moves the agents and
+	// updates the population and food, after which the world is final for
+	// the tick. FinishUpdate() does the rest of the work, which is invisible
+	// to the agents, so the next tick's vision can be rendered during it.
+	void UpdateWorld();
+	void FinishUpdate();
+
+	// Render the agents' vision and start reading it back without waiting
+	// for the GPU. ApplyAgentsVision() waits for the pixels and passes them
+	// to the agents. The agents must not change in between.
+	void SubmitAgentsVision(Graphics* g);
+	void ApplyAgentsVision();
+	bool IsAgentsVisionSubmitted() const { return (m_visionFence != NULL); }
+	const VisionTimes& GetVisionTimes() const { return m_visionTimes; }
+	VisionCache& GetVisionCache() { return m_visionCache; }
+	const PopulationController& GetPopulationController() const { return m_populationController; }
+
+	// Copy what the UI draws into a snapshot, including the details of the
+	// selected agent (if any).
+	void WriteRenderSnapshot(RenderSnapshot& snapshot, unsigned long selectedAgentID);
 	
 	Agent* GetAgent(unsigned long agentID);
 
-	int GetNumFood()	const { return (int) m_food.size(); }
+	int GetNumFood()	const { return m_food.GetNumActive(); }
 	int GetNumAgents()	const { return (int) m_agents.size(); }
 	int GetWorldAge()	const { return m_worldAge; }
+	bool WereStatisticsSampled() const { return m_statisticsSampled; } // During the last tick.
 
 	const SimulationStats& GetStatistics() const { return m_statistics; }
+	const TickProfiler& GetProfiler() const { return m_profiler; }
+	const Statistic& GetGeneStatistic(GeneStatistic stat) const { return m_geneStats[stat]; }
 
 	WorldRenderer* GetWorldRenderer() { return &m_worldRenderer; }
+	const FoodField& GetFood() const { return m_food; }
+	JobSystem* GetJobSystem() { return m_jobSystem; }
 
-	food_list::iterator		food_begin()	{ return m_food.begin(); }
-	food_list::iterator		food_end()		{ return m_food.end(); }
 	agent_list::iterator	agents_begin()	{ return m_agents.begin(); }
 	agent_list::iterator	agents_end()	{ return m_agents.end(); }
 
@@ -119,24 +289,58 @@ protected:
 	void UpdateAgents();
 	void UpdateFood();
 	void UpdateSteadyStateGA();
+	void PreBirthNewborns();
+	void SortAgentsSpatially();
+
+	void AddAgentStatistics(Agent* agent);
+	void RemoveAgentStatistics(Agent* agent);
+	void SampleStatistics();
+	static void GetGeneStatisticValues(Agent* agent, float* values);
+
+	Agent* RequestBirth(BrainGenome* parent1, BrainGenome* parent2, float energy = -1.0f);
+	void GrowBirthRequests();
 
 	Agent* Mate(Agent* mommy, Agent* daddy);
 	void Kill(Agent*& agent);
 	void PickParentsUsingTournament(int numInPool, int* iParent, int* jParent);
+	bool CreateVisionFramebuffer();
+	void PackVisionAtlas();
 	
 
 private:
 	agent_list			m_agents;
-	food_list			m_food;
+	agent_map			m_agentMap; // Agents by ID, so they can be found whatever order they are in.
+	MortonSorter		m_agentSorter;
+	agent_list			m_sortedAgents;
+	agent_list			m_newborns; // Agents waiting to be prebirthed at the end of the tick.
+	std::vector<BirthRequest> m_birthRequests;
+	FoodField			m_food;
 	int					m_worldAge;
+	bool				m_statisticsSampled;
 	
 	unsigned long		m_agentCounter;
 	float*				m_agentVisionPixels;
+	GLuint				m_visionFramebuffer;	// Multisampled framebuffer the vision is rendered into.
+	GLuint				m_visionResolveFramebuffer;
+	GLuint				m_visionRenderbuffers[3]; // Color, depth and resolved color.
+	GLuint				m_visionPixelBuffer;	// Pixel buffer the vision is read back into.
+	GLuint				m_visionTimerQuery;
+	GLsync				m_visionFence;			// Signaled when the readback has finished.
+	int					m_numVisionAgents;
+	int					m_visionAtlasWidth;		// Width of the framebuffer the vision strips are packed into.
+	int					m_visionAtlasHeight;	// Number of rows used by the last vision pass.
+	std::vector<Viewport> m_visionViewports;	// Where each agent's vision strip is in the atlas (empty if cached).
+	VisionCache			m_visionCache;
+	PopulationController m_populationController;
+	VisionTimes			m_visionTimes;
 	FittestList*		m_fittestList;
+	JobSystem*			m_jobSystem;
 	ReplayRecorder		m_replayRecorder;
 	WorldRenderer		m_worldRenderer;
 
 	SimulationStats		m_statistics;
+	Statistic			m_geneStats[NUM_GENE_STATS];
+	TickProfiler		m_profiler;
 	
 public:
 	static SimulationParams PARAMS;
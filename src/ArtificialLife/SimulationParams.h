@@ -1,6 +1,8 @@
 #ifndef _SIMULATION_PARAMS_H_
 #define _SIMULATION_PARAMS_H_
 
+#include <ArtificialLife/brain/ActivationFunction.h>
+
 
 enum BoundaryType
 {
@@ -8,6 +10,14 @@ enum BoundaryType
 	BOUNDARY_TYPE_WRAP,			// Wrap around the edges of the world boundaries.
 	BOUNDARY_TYPE_DEATH,		// Kill agents that leave the world boundaries.
 };
+
+
+enum VisionCacheMode
+{
+	VISION_CACHE_OFF = 0,		// Render every agent's vision every tick.
+	VISION_CACHE_EXACT,			// Reuse an agent's vision while nothing it can see has changed.
+	VISION_CACHE_APPROXIMATE,	// Like exact, but ignore changes smaller than the vision cache thresholds.
+};
 	
 
 struct SimulationParams
@@ -24,7 +34,18 @@ struct SimulationParams
 	int   minFood;
 	int   maxFood;
 	int   initialFoodCount;
+	int   numFoodSites;			// Number of fixed sites where food can grow (at least minFood).
+	int   numFoodPatches;		// Number of patches the food sites are clustered in, or 0 to spread them over the world.
+	float foodPatchRadius;
 	int   initialNumAgents;
+	int   statisticsInterval;	// Number of ticks between samples of the simulation statistics.
+	int   spatialSortInterval;	// Number of ticks between sorting the agents by position, or 0 to never sort them.
+	int   visionUpdateInterval;	// Number of ticks between renders of an agent's vision.
+	int   brainUpdateInterval;	// Number of ticks between updates of an agent's brain. Its outputs are held in between.
+	float targetTicksPerSecond;	// Ticks per second the population cap is adjusted to keep to, or 0 to never adjust it.
+	int   populationControlInterval;	// Number of ticks between adjustments of the population cap.
+	float populationControlHysteresis;	// Fraction the tick time can stray from the target before the cap is adjusted.
+	int   numWorkerThreads;		// Number of threads in the job system (including the main thread), or 0 for one per hardware thread.
 		
 	//-----------------------------------------------------------------------------
 	// Energy and fitness parameters.
@@ -60,8 +81,14 @@ struct SimulationParams
 
 	int   mateWait;				// Time to wait after mating before mating again.
 	int   initialMateWait;		// Time to wait before mating after birth (i.e. age of firtility).
-	int   retinaResolution;		// The resolution width at which an agent's vision is renderered.
+	int   retinaResolution;		// The largest resolution width at which an agent's vision is renderered.
+	int   retinaOversampling;	// Pixels rendered for each neuron of an agent's largest vision channel.
 	float retinaVerticalFOV;	// Vertical field of view in radians, should be very small (like 0.01f).
+	VisionCacheMode visionCacheMode;	// When an agent can reuse its vision from an earlier tick.
+	float visionCacheCellSize;		// Size of the grid cells that changes to the world are tracked in.
+	float visionCacheMoveThreshold;	// Distance something can move before it counts as changed (approximate mode).
+	float visionCacheTurnThreshold;	// Angle in radians something can turn before it counts as changed (approximate mode).
+	float visionCacheColorThreshold;// Change in an agent's color before it counts as changed (approximate mode).
 
 	//-----------------------------------------------------------------------------
 	// Agent gene ranges.
@@ -114,8 +141,11 @@ struct SimulationParams
 	//bool  synapseFromOutputNeurons;
 
 	float logisticSlope;
+	ActivationFunctionType activationFunction;	// Implementation of the sigmoid used to update neurons.
+	float maxActivationError;	// Approximate activation functions with a larger error fall back to the exact one.
 	float maxWeight;
 	float initMaxWeight;
+	bool  compactSynapses;		// Store synapses with 16-bit indices and fixed point efficacies.
 	float decayRate;
 };
 
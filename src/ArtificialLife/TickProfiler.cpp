@@ -0,0 +1,66 @@
+#include "TickProfiler.h"
+#include <AppLib/util/Timing.h>
+
+
+TickProfiler::TickProfiler()
+	: m_smoothing(0.05)
+{
+	Reset();
+}
+
+void TickProfiler::Reset()
+{
+	m_numTicks		= 0;
+	m_tickStartTime	= 0.0;
+	m_lastTickTime	= 0.0;
+	m_avgTickTime	= 0.0;
+
+	for (int i = 0; i < NUM_TICK_PHASES; i++)
+	{
+		m_phaseStartTimes[i]	= 0.0;
+		m_phaseTimes[i]			= 0.0;
+		m_avgPhaseTimes[i]		= 0.0;
+	}
+}
+
+void TickProfiler::BeginTick()
+{
+	for (int i = 0; i < NUM_TICK_PHASES; i++)
+		m_phaseTimes[i] = 0.0;
+	m_tickStartTime = Time::GetTime();
+}
+
+void TickProfiler::EndTick()
+{
+	m_lastTickTime = Time::GetTime() - m_tickStartTime;
+
+	// The first tick initializes the averages.
+	double weight = (m_numTicks == 0 ? 1.0 : m_smoothing);
+	m_avgTickTime += (m_lastTickTime - m_avgTickTime) * weight;
+	for (int i = 0; i < NUM_TICK_PHASES; i++)
+		m_avgPhaseTimes[i] += (m_phaseTimes[i] - m_avgPhaseTimes[i]) * weight;
+
+	m_numTicks++;
+}
+
+void TickProfiler::BeginPhase(TickPhase phase)
+{
+	m_phaseStartTimes[phase] = Time::GetTime();
+}
+
+void TickProfiler::EndPhase(TickPhase phase)
+{
+	m_phaseTimes[phase] += Time::GetTime() - m_phaseStartTimes[phase];
+}
+
+const char* TickProfiler::GetPhaseName(TickPhase phase)
+{
+	switch (phase)
+	{
+	case TICK_PHASE_AGENTS:				return "agents";
+	case TICK_PHASE_STEADY_STATE_GA:	return "steady-state GA";
+	case TICK_PHASE_FOOD:				return "food";
+	case TICK_PHASE_PREBIRTH:			return "prebirth";
+	default:							return "unknown";
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef _TICK_PROFILER_H_
+#define _TICK_PROFILER_H_
+
+
+// The phases of a simulation tick which are timed.
+enum TickPhase
+{
+	TICK_PHASE_AGENTS = 0,			// Eating, updating, killing and mating agents.
+	TICK_PHASE_STEADY_STATE_GA,		// Creating agents when the population is too small.
+	TICK_PHASE_FOOD,				// Regrowing food.
+	TICK_PHASE_PREBIRTH,			// Warming up the brains of newborn agents.
+
+	NUM_TICK_PHASES,
+};
+
+
+//-----------------------------------------------------------------------------
+// TickProfiler - measures how long each phase of a simulation tick takes,
+// keeping a rolling average over recent ticks.
+//-----------------------------------------------------------------------------
+class TickProfiler
+{
+public:
+	TickProfiler();
+
+	void Reset();
+
+	void BeginTick();
+	void EndTick();
+	void BeginPhase(TickPhase phase);
+	void EndPhase(TickPhase phase);
+
+	// Times are in seconds, averaged over recent ticks.
+	double GetPhaseTime(TickPhase phase) const { return m_avgPhaseTimes[phase]; }
+	double GetTickTime() const { return m_avgTickTime; }
+	double GetLastTickTime() const { return m_lastTickTime; }
+	int GetNumTicks() const { return m_numTicks; }
+
+	static const char* GetPhaseName(TickPhase phase);
+
+private:
+	double	m_smoothing; // Weight of the newest tick in the rolling averages.
+	int		m_numTicks;
+
+	double	m_tickStartTime;
+	double	m_lastTickTime;
+	double	m_avgTickTime;
+	double	m_phaseStartTimes[NUM_TICK_PHASES];
+	double	m_phaseTimes[NUM_TICK_PHASES]; // Accumulated during the current tick.
+	double	m_avgPhaseTimes[NUM_TICK_PHASES];
+};
+
+
+#endif // _TICK_PROFILER_H_
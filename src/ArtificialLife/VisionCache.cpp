@@ -0,0 +1,274 @@
+#include "VisionCache.h"
+#include <ArtificialLife/Simulation.h>
+#include <AppLib/math/MathLib.h>
+
+
+VisionCache::VisionCache()
+	: m_cellSize(1.0f)
+	, m_objectRadius(0.0f)
+	, m_gridWidth(0)
+	, m_gridHeight(0)
+	, m_stamp(0)
+	, m_recentCell(-1)
+	, m_numHits(0)
+	, m_numMisses(0)
+	, m_totalHits(0)
+	, m_totalMisses(0)
+{
+}
+
+void VisionCache::Initialize(float worldWidth, float worldHeight, float cellSize, float objectRadius)
+{
+	m_cellSize = Math::Max(1.0f, cellSize);
+	m_objectRadius = objectRadius;
+	m_gridWidth = Math::Max(1, (int) Math::Ceil(worldWidth / m_cellSize));
+	m_gridHeight = Math::Max(1, (int) Math::Ceil(worldHeight / m_cellSize));
+	m_cellStamps.assign(m_gridWidth * m_gridHeight, 0);
+	m_cellNext.assign(m_gridWidth * m_gridHeight, -1);
+	m_cellPrev.assign(m_gridWidth * m_gridHeight, -1);
+	m_recentCell = -1;
+	m_stamp = 0;
+	m_agents.clear();
+	m_foodSizes.clear();
+	m_needsVision.clear();
+	ResetCounters();
+}
+
+void VisionCache::Update(const std::vector<Agent*>& agents, const FoodField& food, float viewDistance)
+{
+	VisionCacheMode mode = Simulation::PARAMS.visionCacheMode;
+	int numAgents = (int) agents.size();
+	m_numHits = 0;
+	m_numMisses = 0;
+
+	// Agents whose vision isn't due this tick keep their last vision, and
+	// don't count as hits or misses.
+	m_needsVision.resize(numAgents);
+	for (int i = 0; i < numAgents; i++)
+	{
+		m_needsVision[i] = (agents[i]->IsVisionUpdateDue() ? 1 : 0);
+		m_numMisses += m_needsVision[i];
+	}
+
+	if (mode == VISION_CACHE_OFF || m_cellStamps.empty())
+	{
+		m_totalMisses += m_numMisses;
+		return;
+	}
+
+	m_stamp++;
+
+	// Stamp the cells of the agents which were born, have died, or have
+	// changed how they look.
+	for (int i = 0; i < numAgents; i++)
+	{
+		AgentAppearance appearance = GetAppearance(agents[i]);
+		auto it = m_agents.find(agents[i]->GetID());
+		if (it == m_agents.end())
+		{
+			AgentEntry entry;
+			entry.appearance = appearance;
+			entry.viewStamp = 0;
+			entry.lastSeenStamp = m_stamp;
+			m_agents[agents[i]->GetID()] = entry;
+			StampCell(appearance.position);
+			continue;
+		}
+
+		AgentEntry& entry = it->second;
+		entry.lastSeenStamp = m_stamp;
+		if (HasChanged(entry.appearance, appearance))
+		{
+			StampCell(entry.appearance.position);
+			StampCell(appearance.position);
+			entry.appearance = appearance;
+		}
+	}
+	for (auto it = m_agents.begin(); it != m_agents.end(); )
+	{
+		if (it->second.lastSeenStamp != m_stamp)
+		{
+			StampCell(it->second.appearance.position);
+			it = m_agents.erase(it);
+		}
+		else
+			++it;
+	}
+
+	// Stamp the cells of the food which has grown or been eaten.
+	m_foodSizes.resize(food.GetNumSites(), 0.0f);
+	for (int i = 0; i < food.GetNumSites(); i++)
+	{
+		if (food.GetSize(i) != m_foodSizes[i])
+		{
+			m_foodSizes[i] = food.GetSize(i);
+			StampCell(food.GetPosition(i));
+		}
+	}
+
+	// An agent needs its vision rendered if it has moved, turned, or a cell
+	// in its view has changed since its vision was last rendered.
+	bool exact = (mode == VISION_CACHE_EXACT);
+	float moveThreshold = (exact ? 0.0f : Simulation::PARAMS.visionCacheMoveThreshold);
+	float turnThreshold = (exact ? 0.0f : Simulation::PARAMS.visionCacheTurnThreshold);
+	for (int i = 0; i < numAgents; i++)
+	{
+		if (!m_needsVision[i])
+			continue;
+
+		Agent* agent = agents[i];
+		AgentEntry& entry = m_agents[agent->GetID()];
+		Vector2f position = agent->GetPosition();
+		float direction = agent->GetDirection();
+		float fov = agent->GetFOV();
+
+		bool miss = (entry.viewStamp == 0 ||
+			fov != entry.viewFOV ||
+			position.DistTo(entry.viewPosition) > moveThreshold ||
+			Math::Abs(direction - entry.viewDirection) > turnThreshold);
+
+		// Visit the cells stamped since the vision was rendered, skipping
+		// those outside the box around the agent that it can see. The far
+		// plane is flat, so the corners of the view reach further than the
+		// view distance. A view of 180 degrees or wider has no bound on the
+		// sides, so the whole grid is searched.
+		int minX = 0;
+		int minY = 0;
+		int maxX = m_gridWidth - 1;
+		int maxY = m_gridHeight - 1;
+		float halfFOV = fov * 0.5f;
+		if (halfFOV < Math::HALF_PI - 0.01f)
+		{
+			float reach = (viewDistance / Math::Cos(halfFOV)) + m_objectRadius;
+			minX = Math::Max(0, (int) ((position.x - reach) / m_cellSize));
+			minY = Math::Max(0, (int) ((position.y - reach) / m_cellSize));
+			maxX = Math::Min(m_gridWidth - 1, (int) ((position.x + reach) / m_cellSize));
+			maxY = Math::Min(m_gridHeight - 1, (int) ((position.y + reach) / m_cellSize));
+		}
+		for (int cell = m_recentCell;
+			 cell >= 0 && m_cellStamps[cell] > entry.viewStamp && !miss;
+			 cell = m_cellNext[cell])
+		{
+			int x = cell % m_gridWidth;
+			int y = cell / m_gridWidth;
+			if (x >= minX && x <= maxX && y >= minY && y <= maxY &&
+				IsCellInView(cell, position, direction, fov, viewDistance))
+				miss = true;
+		}
+
+		if (miss)
+		{
+			entry.viewPosition = position;
+			entry.viewDirection = direction;
+			entry.viewFOV = fov;
+			entry.viewStamp = m_stamp;
+		}
+		else
+		{
+			m_needsVision[i] = 0;
+			m_numHits++;
+			m_numMisses--;
+		}
+	}
+
+	m_totalHits += m_numHits;
+	m_totalMisses += m_numMisses;
+}
+
+float VisionCache::GetHitRate() const
+{
+	long long total = m_totalHits + m_totalMisses;
+	if (total == 0)
+		return 0.0f;
+	return (float) ((double) m_totalHits / (double) total);
+}
+
+void VisionCache::ResetCounters()
+{
+	m_numHits = 0;
+	m_numMisses = 0;
+	m_totalHits = 0;
+	m_totalMisses = 0;
+}
+
+VisionCache::AgentAppearance VisionCache::GetAppearance(Agent* agent)
+{
+	// These are the values the world renderer draws an agent with.
+	AgentAppearance appearance;
+	appearance.position		= agent->GetPosition();
+	appearance.direction	= agent->GetDirection();
+	appearance.size			= agent->GetSize();
+	appearance.color.x		= agent->GetFightAmount();
+	appearance.color.y		= agent->GetGenome()->GetGreenColoration();
+	appearance.color.z		= agent->GetMateAmount();
+	return appearance;
+}
+
+bool VisionCache::HasChanged(const AgentAppearance& a, const AgentAppearance& b) const
+{
+	if (Simulation::PARAMS.visionCacheMode == VISION_CACHE_EXACT)
+	{
+		return (a.position.x != b.position.x || a.position.y != b.position.y ||
+				a.direction != b.direction || a.size != b.size ||
+				a.color.x != b.color.x || a.color.y != b.color.y || a.color.z != b.color.z);
+	}
+
+	float colorThreshold = Simulation::PARAMS.visionCacheColorThreshold;
+	return (a.position.DistTo(b.position) > Simulation::PARAMS.visionCacheMoveThreshold ||
+			Math::Abs(a.direction - b.direction) > Simulation::PARAMS.visionCacheTurnThreshold ||
+			a.size != b.size ||
+			Math::Abs(a.color.x - b.color.x) > colorThreshold ||
+			Math::Abs(a.color.y - b.color.y) > colorThreshold ||
+			Math::Abs(a.color.z - b.color.z) > colorThreshold);
+}
+
+// Test if anything in a cell could be seen from a position. The cell is
+// treated as a circle, grown by the size of the largest object.
+bool VisionCache::IsCellInView(int cell, const Vector2f& position, float direction,
+							   float fov, float viewDistance) const
+{
+	Vector2f center(
+		((cell % m_gridWidth) + 0.5f) * m_cellSize,
+		((cell / m_gridWidth) + 0.5f) * m_cellSize);
+	float radius = (m_cellSize * 0.7072f) + m_objectRadius;
+
+	Vector2f toCell = center - position;
+	float dist = toCell.Length();
+	if (dist <= radius)
+		return true;
+
+	// The far plane cuts at a depth along the view direction, not at a
+	// distance from the agent.
+	Vector2f forward(Math::Cos(direction), -Math::Sin(direction));
+	if (forward.Dot(toCell) - radius > viewDistance)
+		return false;
+
+	float angle = Math::ACos(Math::Clamp(forward.Dot(toCell) / dist, -1.0f, 1.0f));
+	return (angle <= (fov * 0.5f) + Math::ASin(radius / dist));
+}
+
+void VisionCache::StampCell(const Vector2f& position)
+{
+	int x = Math::Clamp((int) (position.x / m_cellSize), 0, m_gridWidth - 1);
+	int y = Math::Clamp((int) (position.y / m_cellSize), 0, m_gridHeight - 1);
+	int cell = (y * m_gridWidth) + x;
+	if (m_cellStamps[cell] == m_stamp)
+		return;
+
+	// Move the cell to the front of the list of stamped cells.
+	if (m_cellStamps[cell] != 0)
+	{
+		if (m_cellPrev[cell] >= 0)
+			m_cellNext[m_cellPrev[cell]] = m_cellNext[cell];
+		else
+			m_recentCell = m_cellNext[cell];
+		if (m_cellNext[cell] >= 0)
+			m_cellPrev[m_cellNext[cell]] = m_cellPrev[cell];
+	}
+	m_cellPrev[cell] = -1;
+	m_cellNext[cell] = m_recentCell;
+	if (m_recentCell >= 0)
+		m_cellPrev[m_recentCell] = cell;
+	m_recentCell = cell;
+	m_cellStamps[cell] = m_stamp;
+}
@@ -0,0 +1,99 @@
+#ifndef _VISION_CACHE_H_
+#define _VISION_CACHE_H_
+
+#include <AppLib/math/Vector2f.h>
+#include <AppLib/math/Vector3f.h>
+#include <vector>
+#include <unordered_map>
+
+class Agent;
+class FoodField;
+
+
+//-----------------------------------------------------------------------------
+// VisionCache - decides which agents need their vision rendered again. The
+// world is split into a grid of cells, and each cell is stamped whenever
+// something drawn in it changes. An agent keeps the vision it saw last if it
+// hasn't moved or turned, and no cell in its view cone has been stamped since
+// its vision was rendered. In exact mode, any change counts. In approximate
+// mode, changes smaller than the vision cache thresholds are ignored.
+//-----------------------------------------------------------------------------
+class VisionCache
+{
+public:
+	VisionCache();
+
+	// Objects can reach up to objectRadius from their positions.
+	void Initialize(float worldWidth, float worldHeight, float cellSize, float objectRadius);
+
+	// Stamp the changes to the world since the last pass, and decide which
+	// agents need their vision rendered in this pass. The agents which miss
+	// are assumed to have their vision rendered.
+	void Update(const std::vector<Agent*>& agents, const FoodField& food, float viewDistance);
+
+	// Whether the agent at the given index in the last pass needs its vision
+	// rendered.
+	bool NeedsVision(int index) const { return (m_needsVision[index] != 0); }
+
+	// Counts for the last pass.
+	int GetNumHits() const { return m_numHits; }
+	int GetNumMisses() const { return m_numMisses; }
+
+	// The fraction of agents which reused their vision, since the counters
+	// were last reset.
+	float GetHitRate() const;
+	void ResetCounters();
+
+private:
+	// How an agent looks to the others, as of the last time its cells were
+	// stamped.
+	struct AgentAppearance
+	{
+		Vector2f	position;
+		float		direction;
+		float		size;
+		Vector3f	color;
+	};
+
+	struct AgentEntry
+	{
+		AgentAppearance	appearance;
+		Vector2f		viewPosition;	// Where the agent's vision was last rendered from.
+		float			viewDirection;
+		float			viewFOV;
+		unsigned int	viewStamp;		// Stamp of the pass its vision was last rendered in.
+		unsigned int	lastSeenStamp;
+	};
+
+	static AgentAppearance GetAppearance(Agent* agent);
+	bool HasChanged(const AgentAppearance& a, const AgentAppearance& b) const;
+	bool IsCellInView(int cell, const Vector2f& position, float direction,
+					  float fov, float viewDistance) const;
+	void StampCell(const Vector2f& position);
+
+	float			m_cellSize;
+	float			m_objectRadius;
+	int				m_gridWidth;
+	int				m_gridHeight;
+	std::vector<unsigned int> m_cellStamps; // Stamp of the last change in each cell.
+	unsigned int	m_stamp;
+
+	// The stamped cells form a linked list, ordered from the most recently
+	// stamped, so an agent only visits the cells that changed since its
+	// vision was rendered.
+	std::vector<int> m_cellNext;
+	std::vector<int> m_cellPrev;
+	int				m_recentCell; // -1 if no cells have been stamped.
+
+	std::unordered_map<unsigned long, AgentEntry> m_agents; // By agent ID.
+	std::vector<float>	m_foodSizes;
+	std::vector<char>	m_needsVision;
+
+	int				m_numHits;
+	int				m_numMisses;
+	long long		m_totalHits;
+	long long		m_totalMisses;
+};
+
+
+#endif // _VISION_CACHE_H_
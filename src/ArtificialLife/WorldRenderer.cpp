@@ -1,5 +1,6 @@
 #include "WorldRenderer.h"
 #include <ArtificialLife/Simulation.h>
+#include <ArtificialLife/RenderSnapshot.h>
 
 
 WorldRenderer::WorldRenderer(Simulation* simulation)
@@ -91,7 +92,7 @@ void WorldRenderer::LoadModels()
 	}
 }
 
-void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV)
+void WorldRenderer::RenderFloor(Graphics* g, ICamera* camera)
 {
 	g->EnableCull(false); // Dont cull.
 	g->EnableDepthTest(true);
@@ -100,11 +101,7 @@ void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV)
 	g->SetProjection(camera->GetViewProjection());
 	g->ResetTransform();
 
-	Vector4f foodColor(0.0f, 1.0f, 0.0f, 1.0f); // green
 	Vector4f floorColor(0.0f, 0.15f, 0.0f, 1.0f); // dark green
-	
-	//-----------------------------------------------------------------------------
-	// Draw the floor.
 
 	glBegin(GL_QUADS);
 	glColor4fv(floorColor.data());
@@ -114,17 +111,42 @@ void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV)
 	glVertex3f(Simulation::PARAMS.worldWidth, Simulation::PARAMS.worldHeight, floorZ);
 	glVertex3f(0.0f, Simulation::PARAMS.worldHeight, floorZ);
 	glEnd();
+}
+
+float WorldRenderer::GetMaxObjectRadius() const
+{
+	float agentRadius = 0.0f;
+	for (unsigned int i = 0; i < m_agentVertices.size(); i++)
+		agentRadius = Math::Max(agentRadius, Vector2f(m_agentVertices[i].x, m_agentVertices[i].y).Length());
+	float foodRadius = 0.0f;
+	for (unsigned int i = 0; i < m_foodVertices.size(); i++)
+		foodRadius = Math::Max(foodRadius, Vector2f(m_foodVertices[i].x, m_foodVertices[i].y).Length());
+
+	return Math::Max(agentRadius * Simulation::PARAMS.maxSize,
+					 foodRadius * FoodField::GetMaxSize());
+}
+
+void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV)
+{
+	Vector4f foodColor(0.0f, 1.0f, 0.0f, 1.0f); // green
+	
+	//-----------------------------------------------------------------------------
+	// Draw the floor.
+
+	RenderFloor(g, camera);
 
 	//-----------------------------------------------------------------------------
 	// Draw food.
 	
-	for (auto it = m_simulation->food_begin(); it < m_simulation->food_end(); ++it)
+	const FoodField& food = m_simulation->GetFood();
+	for (int i = 0; i < food.GetNumSites(); i++)
 	{
-		Food* food = *it;
+		if (!food.IsActive(i))
+			continue;
 
 		g->ResetTransform();
-		g->Translate(food->GetPosition());
-		g->Scale(Vector3f(food->GetSize(), food->GetSize(), 1.0f));
+		g->Translate(food.GetPosition(i));
+		g->Scale(Vector3f(food.GetSize(i), food.GetSize(i), 1.0f));
 
 		glBegin(GL_QUADS);
 		glColor4fv(&foodColor.x);
@@ -164,6 +186,26 @@ void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV)
 	}
 }
 
+// Draw the world as it was when the snapshot was taken.
+void WorldRenderer::RenderWorld(Graphics* g, ICamera* camera, const RenderSnapshot& snapshot, unsigned long agentPOVID)
+{
+	RenderFloor(g, camera);
+
+	for (unsigned int i = 0; i < snapshot.food.size(); i++)
+		RenderFood(g, snapshot.food[i].position, snapshot.food[i].size);
+
+	for (unsigned int i = 0; i < snapshot.agents.size(); i++)
+	{
+		const AgentSnapshot& agent = snapshot.agents[i];
+
+		// Don't render the host agent.
+		if (agent.id == agentPOVID)
+			continue;
+
+		RenderAgent(g, agent.position, agent.direction, agent.size, agent.color);
+	}
+}
+
 void WorldRenderer::RenderAgent(Graphics* g, Agent* agent)
 {
 	g->ResetTransform();
@@ -184,22 +226,6 @@ void WorldRenderer::RenderAgent(Graphics* g, Agent* agent)
 	glEnd();
 }
 
-void WorldRenderer::RenderFood(Graphics* g, Food* food)
-{
-	Color foodColor = Color::GREEN;
-
-	g->ResetTransform();
-	g->Translate(food->GetPosition());
-	g->Scale(food->GetSize());
-
-	glBegin(GL_QUADS);
-	glColor4ubv(foodColor.data());
-	for (unsigned int j = 0; j < m_foodVertices.size(); j++)
-		glVertex3fv(m_foodVertices[j].data());
-
-	glEnd();
-}
-
 void WorldRenderer::RenderAgent(Graphics* g, const Vector2f& pos, float direction, float size, const Color& color)
 {
 	g->ResetTransform();
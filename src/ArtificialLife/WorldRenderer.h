@@ -2,12 +2,13 @@
 #define _WORLD_RENDERER_H_
 
 #include <ArtificialLife/agent/Agent.h>
-#include <ArtificialLife/food/Food.h>
+#include <ArtificialLife/food/FoodField.h>
 #include <ArtificialLife/Camera.h>
 #include <AppLib/graphics/Graphics.h>
 #include <vector>
 
 class Simulation;
+struct RenderSnapshot;
 
 
 class WorldRenderer
@@ -17,15 +18,19 @@ public:
 	
 	void LoadModels();
 	void RenderWorld(Graphics* g, ICamera* camera, Agent* agentPOV);
+	void RenderWorld(Graphics* g, ICamera* camera, const RenderSnapshot& snapshot, unsigned long agentPOVID = 0);
 
 	void RenderAgent(Graphics* g, Agent* agent);
-	void RenderFood(Graphics* g, Food* food);
 	
 	void RenderAgent(Graphics* g, const Vector2f& pos, float direction, float size, const Color& color);
 	void RenderFood(Graphics* g, const Vector2f& pos, float size);
 
+	// The furthest any agent or food can reach from its position.
+	float GetMaxObjectRadius() const;
 
 private:
+	void RenderFloor(Graphics* g, ICamera* camera);
+
 	Simulation* m_simulation;
 	
 	std::vector<Vector3f> m_agentVertices;
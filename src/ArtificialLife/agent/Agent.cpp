@@ -44,18 +44,26 @@ void Agent::Birth(AgentCreation creationType, unsigned long parent1, unsigned lo
 	m_parents[1]	= parent2;
 }
 
-// Grow an agent from its genome.
-void Agent::Grow()
+// Grow an agent from its genome. PreBirth() must be called afterwards
+// (before the agent's first update). This doesn't touch any shared state,
+// so multiple agents can be grown on separate threads.
+void Agent::Grow(RandomNumberGenerator& rng)
 {
-	// Grow the brain and some random signals to it.
+	// Grow the brain.
 	m_cns->Grow(m_brainGenome);
-	m_cns->PreBirth();
 	
 	// Configure the nerves and retina.
 	m_retina.SetFOV(m_brainGenome->GetFOV());
 	m_retina.ConfigureChannel(0, m_cns->GetNerve(0));
 	m_retina.ConfigureChannel(1, m_cns->GetNerve(1));
 	m_retina.ConfigureChannel(2, m_cns->GetNerve(2));
+
+	// Render only as many pixels as the largest vision channel needs.
+	int maxVisionNeurons = Math::Max(m_retina.GetNumNeurons(0),
+		Math::Max(m_retina.GetNumNeurons(1), m_retina.GetNumNeurons(2)));
+	m_retina.SetResolution(Math::Clamp(
+		maxVisionNeurons * Simulation::PARAMS.retinaOversampling,
+		1, Simulation::PARAMS.retinaResolution));
 	m_nerves.energy		= m_cns->GetNerve(3);
 	m_nerves.random		= m_cns->GetNerve(4);
 	m_nerves.moveSpeed	= m_cns->GetNerve(5);
@@ -83,7 +91,7 @@ void Agent::Grow()
 	m_energy			= m_maxEnergy; // Starting energy for generated agents (not born).
 	m_heuristicFitness	= 0.0f;
 	m_velocity			= Vector2f::ZERO;
-	m_direction			= Random::NextFloat() * Math::TWO_PI;
+	m_direction			= rng.NextFloat() * Math::TWO_PI;
 	m_numFoodEaten		= 0;
 	m_numChildren		= 0;
 	m_energyUsage		= 0.0f;
@@ -96,6 +104,13 @@ void Agent::Grow()
 }
 
 
+// Warm up the brain by feeding it some random signals.
+void Agent::PreBirth()
+{
+	m_cns->PreBirth();
+}
+
+
 //-----------------------------------------------------------------------------
 // Getters.
 //-----------------------------------------------------------------------------
@@ -120,6 +135,26 @@ bool Agent::CanMate() const
 	return (m_mateTimer <= 0);
 }
 
+bool Agent::IsVisionUpdateDue() const
+{
+	return IsUpdateDue(Simulation::PARAMS.visionUpdateInterval);
+}
+
+bool Agent::IsBrainUpdateDue() const
+{
+	return IsUpdateDue(Simulation::PARAMS.brainUpdateInterval);
+}
+
+// Updates which run less often than every tick are staggered by the agent's
+// ID, so about the same number of agents update on each tick. Newborns always
+// update on their first tick.
+bool Agent::IsUpdateDue(int interval) const
+{
+	if (interval <= 1 || m_age == 0)
+		return true;
+	return ((m_age + m_id) % (unsigned long) interval == 0);
+}
+
 int Agent::GetNumParents() const
 {
 	if (m_creationType == AgentCreation::CREATED_MATE || m_creationType == AgentCreation::BORN)
@@ -157,7 +192,8 @@ void Agent::Update()
 	if (m_energy > m_maxEnergy)
 		m_energy = m_maxEnergy;
 
-	UpdateBrain();
+	if (IsBrainUpdateDue())
+		UpdateBrain();
 		
 	//-----------------------------------------------------------------------------
 	// Update movement.
@@ -36,7 +36,8 @@ public:
 	// Creation.
 
 	void Birth(AgentCreation creationType, unsigned long parent1 = NULL_ID, unsigned long parent2 = NULL_ID);
-	void Grow();
+	void Grow(RandomNumberGenerator& rng);
+	void PreBirth();
 
 	//-----------------------------------------------------------------------------
 	// Update.
@@ -94,6 +95,8 @@ public:
 	float		GetFightRadius() const;
 	bool		CanMate() const;
 	int			GetNumParents() const;
+	bool		IsVisionUpdateDue() const;
+	bool		IsBrainUpdateDue() const;
 	
 	//-----------------------------------------------------------------------------
 	// Setters.
@@ -107,6 +110,8 @@ public:
 
 
 private:
+	bool IsUpdateDue(int interval) const;
+
 	Simulation* m_simulation;
 
 	struct Nerves
@@ -14,6 +14,8 @@ public:
 
 	float GetFOV() const { return m_fov; }
 	void SetFOV(float fov) { m_fov = fov; }
+	int GetResolution() const { return m_resolution; }
+	void SetResolution(int resolution) { m_resolution = resolution; }
 
 	void Update(const float* pixels, int width);
 	void UpdateNerves();
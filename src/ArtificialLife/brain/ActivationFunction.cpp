@@ -0,0 +1,244 @@
+#include "ActivationFunction.h"
+#include <AppLib/math/MathLib.h>
+#include <emmintrin.h>
+#include <cmath>
+
+
+const float ActivationFunction::TABLE_RANGE = 16.0f;
+
+ActivationFunctionType ActivationFunction::s_type = ACTIVATION_FUNCTION_EXACT;
+float ActivationFunction::s_maxError = 0.0f;
+ActivationFunction::ApplyFunc ActivationFunction::s_applyFunc = &ActivationFunction::ApplyExact;
+float ActivationFunction::s_table[ActivationFunction::TABLE_SIZE + 1];
+bool ActivationFunction::s_tableBuilt = false;
+
+
+//-----------------------------------------------------------------------------
+// Selection
+//-----------------------------------------------------------------------------
+
+ActivationFunctionType ActivationFunction::Initialize(ActivationFunctionType type, float maxError)
+{
+	BuildTable();
+
+	float error = 0.0f;
+	if (type != ACTIVATION_FUNCTION_EXACT)
+	{
+		error = ComputeMaxError(type);
+		if (error > maxError)
+		{
+			type = ACTIVATION_FUNCTION_EXACT;
+			error = 0.0f;
+		}
+	}
+
+	SetType(type);
+	s_maxError = error;
+	return s_type;
+}
+
+void ActivationFunction::SetType(ActivationFunctionType type)
+{
+	BuildTable();
+
+	s_type = type;
+	if (type == ACTIVATION_FUNCTION_TABLE)
+		s_applyFunc = &ApplyTable;
+	else if (type == ACTIVATION_FUNCTION_RATIONAL)
+		s_applyFunc = &ApplyRational;
+	else if (type == ACTIVATION_FUNCTION_SIMD)
+		s_applyFunc = &ApplySIMD;
+	else
+		s_applyFunc = &ApplyExact;
+}
+
+const char* ActivationFunction::GetName(ActivationFunctionType type)
+{
+	switch (type)
+	{
+	case ACTIVATION_FUNCTION_EXACT:		return "exact";
+	case ACTIVATION_FUNCTION_TABLE:		return "table";
+	case ACTIVATION_FUNCTION_RATIONAL:	return "rational";
+	case ACTIVATION_FUNCTION_SIMD:		return "simd";
+	default:							return "unknown";
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Evaluation
+//-----------------------------------------------------------------------------
+
+void ActivationFunction::Apply(float* values, int count, float slope)
+{
+	s_applyFunc(values, count, slope);
+}
+
+void ActivationFunction::Apply(ActivationFunctionType type, float* values, int count, float slope)
+{
+	if (type == ACTIVATION_FUNCTION_TABLE)
+		ApplyTable(values, count, slope);
+	else if (type == ACTIVATION_FUNCTION_RATIONAL)
+		ApplyRational(values, count, slope);
+	else if (type == ACTIVATION_FUNCTION_SIMD)
+		ApplySIMD(values, count, slope);
+	else
+		ApplyExact(values, count, slope);
+}
+
+float ActivationFunction::Evaluate(ActivationFunctionType type, float x)
+{
+	BuildTable();
+	Apply(type, &x, 1, 1.0f);
+	return x;
+}
+
+float ActivationFunction::ComputeMaxError(ActivationFunctionType type, int numSamples)
+{
+	// Sample a range slightly wider than the table, to also cover the
+	// saturated ends.
+	const int BATCH_SIZE = 256;
+	float exact[BATCH_SIZE];
+	float approx[BATCH_SIZE];
+	float range = TABLE_RANGE + 4.0f;
+	float maxError = 0.0f;
+
+	BuildTable();
+
+	for (int i = 0; i < numSamples; i += BATCH_SIZE)
+	{
+		int count = Math::Min(BATCH_SIZE, numSamples - i);
+		for (int j = 0; j < count; j++)
+		{
+			exact[j] = -range + (2.0f * range * (i + j)) / (numSamples - 1);
+			approx[j] = exact[j];
+		}
+		ApplyExact(exact, count, 1.0f);
+		Apply(type, approx, count, 1.0f);
+		for (int j = 0; j < count; j++)
+			maxError = Math::Max(maxError, fabsf(approx[j] - exact[j]));
+	}
+
+	return maxError;
+}
+
+
+//-----------------------------------------------------------------------------
+// Implementations
+//-----------------------------------------------------------------------------
+
+void ActivationFunction::BuildTable()
+{
+	if (s_tableBuilt)
+		return;
+	for (int i = 0; i <= TABLE_SIZE; i++)
+	{
+		double x = -TABLE_RANGE + (2.0 * TABLE_RANGE * i) / TABLE_SIZE;
+		s_table[i] = (float) (1.0 / (1.0 + exp(-x)));
+	}
+	s_tableBuilt = true;
+}
+
+void ActivationFunction::ApplyExact(float* values, int count, float slope)
+{
+	for (int i = 0; i < count; i++)
+		values[i] = (1.0f / (1.0f + expf(-values[i] * slope)));
+}
+
+void ActivationFunction::ApplyTable(float* values, int count, float slope)
+{
+	const float scale = (TABLE_SIZE / (2.0f * TABLE_RANGE));
+	const float maxIndex = (float) TABLE_SIZE - 0.0001f;
+
+	for (int i = 0; i < count; i++)
+	{
+		// Map x to a fractional index into the table, clamped to its ends.
+		float t = (values[i] * slope + TABLE_RANGE) * scale;
+		if (t < 0.0f)
+			t = 0.0f;
+		else if (t > maxIndex)
+			t = maxIndex;
+
+		int index = (int) t;
+		float frac = t - (float) index;
+		values[i] = s_table[index] + frac * (s_table[index + 1] - s_table[index]);
+	}
+}
+
+void ActivationFunction::ApplyRational(float* values, int count, float slope)
+{
+	// sigmoid(x) = 0.5 + 0.5 * tanh(x / 2), where tanh is approximated with
+	// a truncated continued fraction (Lambert). The approximation is only
+	// good up to about |x| = 5, beyond which tanh is within 1e-4 of +/-1.
+	const float CLAMP = 4.97f;
+
+	for (int i = 0; i < count; i++)
+	{
+		float x = values[i] * slope * 0.5f;
+		if (x > CLAMP)
+			x = CLAMP;
+		else if (x < -CLAMP)
+			x = -CLAMP;
+
+		float x2 = x * x;
+		float p = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+		float q = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+		values[i] = 0.5f + 0.5f * (p / q);
+	}
+}
+
+void ActivationFunction::ApplySIMD(float* values, int count, float slope)
+{
+	// exp(-x) is computed as 2^n * exp(r), with n = round(-x / ln(2)) and
+	// exp(r) approximated by a polynomial (the same one as cephes expf).
+	const __m128 vSlope		= _mm_set1_ps(-slope);
+	const __m128 vMax		= _mm_set1_ps(88.0f);
+	const __m128 vMin		= _mm_set1_ps(-88.0f);
+	const __m128 vLog2e		= _mm_set1_ps(1.44269504088896341f);
+	const __m128 vLn2Hi		= _mm_set1_ps(0.693359375f);
+	const __m128 vLn2Lo		= _mm_set1_ps(-2.12194440e-4f);
+	const __m128 vHalf		= _mm_set1_ps(0.5f);
+	const __m128 vOne		= _mm_set1_ps(1.0f);
+	const __m128 vP0		= _mm_set1_ps(1.9875691500e-4f);
+	const __m128 vP1		= _mm_set1_ps(1.3981999507e-3f);
+	const __m128 vP2		= _mm_set1_ps(8.3334519073e-3f);
+	const __m128 vP3		= _mm_set1_ps(4.1665795894e-2f);
+	const __m128 vP4		= _mm_set1_ps(1.6666665459e-1f);
+	const __m128 vP5		= _mm_set1_ps(5.0000001201e-1f);
+	const __m128i vBias		= _mm_set1_epi32(0x7F);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(values + i), vSlope);
+		x = _mm_min_ps(_mm_max_ps(x, vMin), vMax);
+
+		// n = floor(x / ln(2) + 0.5)
+		__m128 fx = _mm_add_ps(_mm_mul_ps(x, vLog2e), vHalf);
+		__m128 tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+		fx = _mm_sub_ps(tmp, _mm_and_ps(_mm_cmpgt_ps(tmp, fx), vOne));
+
+		// r = x - n * ln(2)
+		x = _mm_sub_ps(x, _mm_mul_ps(fx, vLn2Hi));
+		x = _mm_sub_ps(x, _mm_mul_ps(fx, vLn2Lo));
+
+		// exp(r)
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 y = vP0;
+		y = _mm_add_ps(_mm_mul_ps(y, x), vP1);
+		y = _mm_add_ps(_mm_mul_ps(y, x), vP2);
+		y = _mm_add_ps(_mm_mul_ps(y, x), vP3);
+		y = _mm_add_ps(_mm_mul_ps(y, x), vP4);
+		y = _mm_add_ps(_mm_mul_ps(y, x), vP5);
+		y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, x2), x), vOne);
+
+		// Multiply by 2^n.
+		__m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), vBias);
+		y = _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+
+		_mm_storeu_ps(values + i, _mm_div_ps(vOne, _mm_add_ps(vOne, y)));
+	}
+
+	// Finish the remaining values.
+	ApplyExact(values + i, count - i, slope);
+}
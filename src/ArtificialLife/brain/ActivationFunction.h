@@ -0,0 +1,74 @@
+#ifndef _ACTIVATION_FUNCTION_H_
+#define _ACTIVATION_FUNCTION_H_
+
+
+// The different implementations of the logistic (sigmoid) activation
+// function which can be used to update neurons.
+enum ActivationFunctionType
+{
+	ACTIVATION_FUNCTION_EXACT = 0,	// 1 / (1 + expf(-x)), used as the reference.
+	ACTIVATION_FUNCTION_TABLE,		// Lookup table with linear interpolation.
+	ACTIVATION_FUNCTION_RATIONAL,	// Rational approximation of tanh.
+	ACTIVATION_FUNCTION_SIMD,		// SSE2 polynomial exp, 4 neurons at a time.
+
+	NUM_ACTIVATION_FUNCTION_TYPES,
+};
+
+
+//-----------------------------------------------------------------------------
+// ActivationFunction - static functions for evaluating the sigmoid over
+// arrays of neuron activations.
+//-----------------------------------------------------------------------------
+class ActivationFunction
+{
+public:
+	// Select the activation function to use. If the approximation's maximum
+	// absolute error is larger than maxError, then the exact function is used
+	// instead. Returns the type which was selected.
+	static ActivationFunctionType Initialize(ActivationFunctionType type, float maxError);
+
+	static ActivationFunctionType GetType() { return s_type; }
+
+	// The maximum absolute error of the selected function, measured when it
+	// was selected.
+	static float GetMaxError() { return s_maxError; }
+
+	// Switch to another implementation without measuring its error, for
+	// comparing the implementations.
+	static void SetType(ActivationFunctionType type);
+	static const char* GetName(ActivationFunctionType type);
+
+	// Apply the sigmoid function in-place to an array of values:
+	// values[i] = 1 / (1 + exp(-values[i] * slope))
+	static void Apply(float* values, int count, float slope);
+	static void Apply(ActivationFunctionType type, float* values, int count, float slope);
+
+	// Evaluate a single value with the given implementation.
+	static float Evaluate(ActivationFunctionType type, float x);
+
+	// Measure the maximum absolute error of an implementation compared to
+	// the exact function, sampled over the range where it is not saturated.
+	static float ComputeMaxError(ActivationFunctionType type, int numSamples = 100000);
+
+private:
+	static void BuildTable();
+
+	static void ApplyExact(float* values, int count, float slope);
+	static void ApplyTable(float* values, int count, float slope);
+	static void ApplyRational(float* values, int count, float slope);
+	static void ApplySIMD(float* values, int count, float slope);
+
+	typedef void (*ApplyFunc)(float* values, int count, float slope);
+
+	static const int TABLE_SIZE = 4096;
+	static const float TABLE_RANGE; // Table covers [-TABLE_RANGE, TABLE_RANGE]
+
+	static ActivationFunctionType s_type;
+	static float s_maxError;
+	static ApplyFunc s_applyFunc;
+	static float s_table[TABLE_SIZE + 1];
+	static bool s_tableBuilt;
+};
+
+
+#endif // _ACTIVATION_FUNCTION_H_
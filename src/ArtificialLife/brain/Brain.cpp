@@ -1,8 +1,10 @@
 #include "Brain.h"
+#include "NervousSystem.h"
 #include <ArtificialLife/Simulation.h>
 #include <AppLib/math/MathLib.h>
 #include <AppLib/util/Random.h>
 #include <assert.h>
+#include <iostream>
 
 
 Brain::Brain(NervousSystem* cns)
@@ -187,6 +189,7 @@ void Brain::Grow(BrainGenome* genome)
 		{
             int neuronIndexTo = firstENeuron[groupTo] + neuronLocalIndexTo;
 			int startSynapse = synapseCounter;
+			int startRun = m_neuronModel->GetNumSynapseRuns();
 
 			GrowSynapses(groupTo,
 						 neuronCountTo,
@@ -207,7 +210,8 @@ void Brain::Grow(BrainGenome* genome)
 						 synapseCounter,
 						 BrainGenome::SYNAPSE_IE);
 			
-			m_neuronModel->SetNeuron(neuronIndexTo, neuronAttrs, startSynapse, synapseCounter); 
+			m_neuronModel->SetNeuron(neuronIndexTo, neuronAttrs, startSynapse, synapseCounter,
+				startRun, m_neuronModel->GetNumSynapseRuns());
 		}
 
 		// Setup inhibitory neurons for this group.
@@ -219,6 +223,7 @@ void Brain::Grow(BrainGenome* genome)
 		{
             int neuronIndexTo = firstINeuron[groupTo] + neuronLocalIndexTo;
 			int startSynapse = synapseCounter;
+			int startRun = m_neuronModel->GetNumSynapseRuns();
 
 			GrowSynapses(groupTo,
 						 neuronCountTo,
@@ -239,7 +244,8 @@ void Brain::Grow(BrainGenome* genome)
 						 synapseCounter,
 						 BrainGenome::SYNAPSE_EI);
 			
-			m_neuronModel->SetNeuron(neuronIndexTo, neuronAttrs, startSynapse, synapseCounter); 
+			m_neuronModel->SetNeuron(neuronIndexTo, neuronAttrs, startSynapse, synapseCounter,
+				startRun, m_neuronModel->GetNumSynapseRuns());
 		}
 	}
 
@@ -253,6 +259,12 @@ void Brain::Grow(BrainGenome* genome)
 		std::cout << "ERROR: incorrect number of synapses!" << std::endl;
 	}
 
+	// Store the internal neurons in a cache-friendly order.
+	m_neuronModel->OrderNeurons();
+
+	if (Simulation::PARAMS.compactSynapses)
+		m_neuronModel->SetSynapseFormat(SYNAPSE_FORMAT_COMPACT);
+
 	//-----------------------------------------------------------------------------
 	// Cleanup.
 
@@ -331,8 +343,9 @@ void Brain::GrowSynapses(int groupTo,
 		int neuronLocalIndex_fromBase = (int) (((float) neuronLocalIndex_to / ((float) neuronCount_to - 1.0f)) * (neuronCount_from - synapseCount_new));
 		neuronLocalIndex_fromBase = Math::Clamp(neuronLocalIndex_fromBase, 0, neuronCount_from - synapseCount_new);
 				
-		bool* neuronsUsed = new bool[neuronCount_from];
-		memset(neuronsUsed, 0, neuronCount_from);
+		m_neuronsUsed.Resize(neuronCount_from);
+
+		long startSynapse = synapseCounter;
 		
 		// Grow a certain number of synapses.
 		for (int isyn = 0; isyn < synapseCount_new; isyn++)
@@ -357,7 +370,7 @@ void Brain::GrowSynapses(int groupTo,
 
 			// Make sure this neuron isnt already connected to.
 			if (firstNeuron[groupFrom] + neuronLocalIndex_from == neuronIndex_to || // same neuron
-				neuronsUsed[neuronLocalIndex_from]) // already connected to this one
+				m_neuronsUsed.Get(neuronLocalIndex_from)) // already connected to this one
 			{
 				// Are we connecting this bunch of neurons to itself?
 				if (groupTo == groupFrom && // same group
@@ -365,21 +378,19 @@ void Brain::GrowSynapses(int groupTo,
 					m_genome->IsOutputGroup(groupTo)))
 				{
 					neuronLocalIndex_from = NearestFreeNeuron(neuronLocalIndex_from,
-															  neuronsUsed,
-															  neuronCount_from,
+															  m_neuronsUsed,
 															  neuronLocalIndex_to);
 				}
 				else
 				{
 					neuronLocalIndex_from = NearestFreeNeuron(neuronLocalIndex_from,
-															  neuronsUsed,
-															  neuronCount_from,
+															  m_neuronsUsed,
 															  neuronLocalIndex_from);
 				}
 			}
 			
 			// Mark this neuron as 'used'.
-			neuronsUsed[neuronLocalIndex_from] = true;
+			m_neuronsUsed.Set(neuronLocalIndex_from);
 
 			int neuronIndex_from = firstNeuron[groupFrom] + neuronLocalIndex_from;
 			
@@ -393,88 +404,301 @@ void Brain::GrowSynapses(int groupTo,
 			else
 				efficacy = m_rng.NextFloat(initminweight, Simulation::PARAMS.initMaxWeight);
 
-			// Learning Rate. TODO: option to turn off output synapse learning.
-			float learningRate = synapseInfo.synapseLearningRate;
-			
 			// Finally, configure the synapse in the neural-net.
 			m_neuronModel->SetSynapse(synapseCounter,
 									  neuronIndex_from,
-									  neuronIndex_to,
-									  efficacy,
-									  learningRate);
+									  efficacy);
 			synapseCounter++;
 		}
-		
 
-		delete [] neuronsUsed;
+		// All synapses from this group share the same learning rate.
+		// TODO: option to turn off output synapse learning.
+		if (synapseCounter > startSynapse)
+		{
+			m_neuronModel->AddSynapseRun(startSynapse, synapseCounter,
+										 synapseInfo.synapseLearningRate);
+		}
 	}
 }
 
-int Brain::NearestFreeNeuron(int iin, bool* used, int num, int exclude)
+// Find the free neuron nearest to the given one (excluding itself and the
+// neuron 'exclude'). Ties are broken towards the higher index.
+int Brain::NearestFreeNeuron(int iin, const BitSet& used, int exclude)
+{
+	int above = used.FindNextUnset(iin + 1);
+	if (above >= 0 && above == exclude)
+		above = used.FindNextUnset(exclude + 1);
+
+	int below = used.FindPrevUnset(iin - 1);
+	if (below >= 0 && below == exclude)
+		below = used.FindPrevUnset(exclude - 1);
+
+	assert(above >= 0 || below >= 0); // NearestFreeNeuron search failed!!!
+
+	if (below < 0 || (above >= 0 && above - iin <= iin - below))
+		return above;
+	return below;
+}
+
+// The original search for the nearest free neuron, which steps outwards from
+// the given neuron one at a time, alternating above and below. It is only
+// kept to check NearestFreeNeuron against. Returns -1 if there is no free
+// neuron.
+static int NearestFreeNeuronReference(int iin, const BitSet& used, int exclude)
 {
-    int iout;
-    bool tideishigh;
-    int hitide = iin;
-    int lotide = iin;
-
-    if (iin < num - 1)
-    {
-        iout = iin + 1;
-        tideishigh = true;
-    }
-    else
-    {
-        iout = iin - 1;
-        tideishigh = false;
-    }
-
-    while (used[iout] || iout == exclude)
-    {
-        if (tideishigh)
-        {
-            hitide = iout;
-            if (lotide > 0)
-            {
-                iout = lotide - 1;
-                tideishigh = false;
-            }
-            else if (hitide < num - 1)
-                iout++;
-        }
-        else
-        {
-            lotide = iout;
-            if (hitide < num - 1)
-            {
-                iout = hitide + 1;
-                tideishigh = true;
-            }
-            else if (lotide > 0)
-                iout--;
-        }
-
-        if (lotide == 0 && hitide == num - 1)
-			assert(false); // NearestFreeNeuron search failed!!!
-    }
-
-    return iout;
+	int num = used.GetSize();
+	int iout;
+	bool tideishigh;
+	int hitide = iin;
+	int lotide = iin;
+
+	if (iin < num - 1)
+	{
+		iout = iin + 1;
+		tideishigh = true;
+	}
+	else
+	{
+		iout = iin - 1;
+		tideishigh = false;
+	}
+
+	while (used.Get(iout) || iout == exclude)
+	{
+		if (tideishigh)
+		{
+			hitide = iout;
+			if (lotide > 0)
+			{
+				iout = lotide - 1;
+				tideishigh = false;
+			}
+			else if (hitide < num - 1)
+				iout++;
+		}
+		else
+		{
+			lotide = iout;
+			if (hitide < num - 1)
+			{
+				iout = hitide + 1;
+				tideishigh = true;
+			}
+			else if (lotide > 0)
+				iout--;
+		}
+
+		if (lotide == 0 && hitide == num - 1)
+			return -1;
+	}
+
+	return iout;
+}
+
+// Compare NearestFreeNeuron with the original search. Every set of used
+// neurons in small groups is tried, then random ones in groups which span
+// several words of the bit set. Only searches which can succeed are tried.
+int Brain::CheckNearestFreeNeuron(int numTrials)
+{
+	RandomNumberGenerator rng(1);
+	BitSet used;
+	int numChecked = 0;
+	int numMismatches = 0;
+
+	auto check = [&](int iin, int exclude)
+	{
+		int expected = NearestFreeNeuronReference(iin, used, exclude);
+		if (expected < 0)
+			return;
+		if (NearestFreeNeuron(iin, used, exclude) != expected)
+			numMismatches++;
+		numChecked++;
+	};
+
+	for (int num = 2; num <= 10; num++)
+	{
+		used.Resize(num);
+		for (int pattern = 0; pattern < (1 << num); pattern++)
+		{
+			used.ClearAll();
+			for (int i = 0; i < num; i++)
+			{
+				if (pattern & (1 << i))
+					used.Set(i);
+			}
+			for (int iin = 0; iin < num; iin++)
+			{
+				for (int exclude = 0; exclude < num; exclude++)
+					check(iin, exclude);
+			}
+		}
+	}
+
+	for (int n = 0; n < numTrials; n++)
+	{
+		int num = rng.NextInt(2, 200);
+		float density = rng.NextFloat();
+		used.Resize(num);
+		for (int i = 0; i < num; i++)
+		{
+			if (rng.NextFloat() < density)
+				used.Set(i);
+		}
+		check(rng.NextInt(0, num), rng.NextInt(0, num));
+	}
+
+	std::cout << "Nearest free neuron check: " << numMismatches << " mismatches in "
+		<< numChecked << " searches" << std::endl;
+	assert(numMismatches == 0);
+	return numMismatches;
 }
 
 
 void Brain::PreBirth()
 {
+	// The random inputs come from this brain's own generator (rather than the
+	// global one), so that brains can be prebirthed on separate threads.
+	RandomNumberGenerator4 rng(m_rng.NextInt());
+	const NeuronModel::Dimensions& dims = m_neuronModel->GetDimensions();
+
 	for (int i = 0; i < Simulation::PARAMS.numPrebirthCycles; i++)
 	{
 		// Feed randomized values to the neural net's inputs.
-		int inputNeuronsBegin = m_neuronModel->GetDimensions().GetInputNeuronsBegin();
-		int inputNeuronsEnd   = m_neuronModel->GetDimensions().GetInputNeuronsEnd();
-		for (int i = inputNeuronsBegin; i < inputNeuronsEnd; i++)
-		{
-			m_neuronModel->SetNeuronActivation(i, Random::NextFloat());
-		}
+		float* activations = *m_neuronModel->GetActivationsBuffer();
+		rng.NextFloats(activations + dims.GetInputNeuronsBegin(), dims.numInputNeurons);
 
 		// Update the net.
 		m_neuronModel->Update();
 	}
 }
 
+// Compare the outputs of brains stored in the given synapse format with the
+// same brains stored with 32-bit floats, when fed the same random inputs.
+void Brain::ReportSynapseFormatError(SynapseFormat format, int numBrains, int numTicks)
+{
+	RandomNumberGenerator rng(1);
+
+	float maxError = 0.0f;
+	double totalError = 0.0;
+	long numSamples = 0;
+	double floatBytes = 0.0;
+	double formatBytes = 0.0;
+
+	bool compactSynapses = Simulation::PARAMS.compactSynapses;
+	Simulation::PARAMS.compactSynapses = false;
+
+	for (int n = 0; n < numBrains; n++)
+	{
+		BrainGenome genome;
+		genome.Randomize(rng);
+		NervousSystem cns;
+		cns.Grow(&genome);
+
+		NeuronModel* floatModel = cns.GetBrain()->GetNeuralNet();
+		NeuronModel formatModel;
+		formatModel.CopyFrom(*floatModel);
+		if (!formatModel.SetSynapseFormat(format))
+			continue;
+
+		floatBytes += floatModel->GetSynapseMemoryUsage();
+		formatBytes += formatModel.GetSynapseMemoryUsage();
+
+		const NeuronModel::Dimensions& dims = floatModel->GetDimensions();
+
+		for (int t = 0; t < numTicks; t++)
+		{
+			for (int i = dims.GetInputNeuronsBegin(); i < dims.GetInputNeuronsEnd(); i++)
+			{
+				float activation = rng.NextFloat();
+				floatModel->SetNeuronActivation(i, activation);
+				formatModel.SetNeuronActivation(i, activation);
+			}
+
+			floatModel->Update();
+			formatModel.Update();
+
+			for (int i = dims.GetOutputNeuronsBegin(); i < dims.GetOutputNeuronsEnd(); i++)
+			{
+				float error = Math::Abs(floatModel->GetNeuronActivation(i) -
+					formatModel.GetNeuronActivation(i));
+				maxError = Math::Max(maxError, error);
+				totalError += error;
+				numSamples++;
+			}
+		}
+	}
+
+	Simulation::PARAMS.compactSynapses = compactSynapses;
+
+	std::cout << "Synapse format error over " << numBrains << " brains, "
+		<< numTicks << " ticks: max = " << maxError
+		<< ", mean = " << (numSamples > 0 ? totalError / numSamples : 0.0)
+		<< ", memory = " << (int) (floatBytes > 0.0 ? (100.0 * formatBytes / floatBytes) : 100.0)
+		<< "% of fp32" << std::endl;
+}
+
+// Run pairs of identical brains side by side, one with the exact activation
+// function and one with the given approximation, and report how far their
+// outputs drift apart. The brains are recurrent, so small errors in the
+// activation function can grow over the ticks. An output counts as flipped
+// when the two brains fall on different sides of 0.5, which is roughly where
+// the agents' behaviors switch on and off.
+void Brain::ReportActivationFunctionDrift(ActivationFunctionType type, int numBrains, int numTicks)
+{
+	RandomNumberGenerator rng(1);
+
+	float maxDrift = 0.0f;
+	double totalDrift = 0.0;
+	long numSamples = 0;
+	long numFlipped = 0;
+
+	ActivationFunctionType prevType = ActivationFunction::GetType();
+
+	for (int n = 0; n < numBrains; n++)
+	{
+		BrainGenome genome;
+		genome.Randomize(rng);
+		NervousSystem cns;
+		cns.Grow(&genome);
+
+		NeuronModel* exactModel = cns.GetBrain()->GetNeuralNet();
+		NeuronModel approxModel;
+		approxModel.CopyFrom(*exactModel);
+
+		const NeuronModel::Dimensions& dims = exactModel->GetDimensions();
+
+		for (int t = 0; t < numTicks; t++)
+		{
+			for (int i = dims.GetInputNeuronsBegin(); i < dims.GetInputNeuronsEnd(); i++)
+			{
+				float activation = rng.NextFloat();
+				exactModel->SetNeuronActivation(i, activation);
+				approxModel.SetNeuronActivation(i, activation);
+			}
+
+			ActivationFunction::SetType(ACTIVATION_FUNCTION_EXACT);
+			exactModel->Update();
+			ActivationFunction::SetType(type);
+			approxModel.Update();
+
+			for (int i = dims.GetOutputNeuronsBegin(); i < dims.GetOutputNeuronsEnd(); i++)
+			{
+				float exact = exactModel->GetNeuronActivation(i);
+				float approx = approxModel.GetNeuronActivation(i);
+				float drift = Math::Abs(exact - approx);
+				maxDrift = Math::Max(maxDrift, drift);
+				totalDrift += drift;
+				numSamples++;
+				if ((exact > 0.5f) != (approx > 0.5f))
+					numFlipped++;
+			}
+		}
+	}
+
+	ActivationFunction::SetType(prevType);
+
+	std::cout << ActivationFunction::GetName(type) << " activation function drift over "
+		<< numBrains << " brains, " << numTicks << " ticks: max = " << maxDrift
+		<< ", mean = " << (numSamples > 0 ? totalDrift / numSamples : 0.0)
+		<< ", flipped outputs = " << numFlipped << "/" << numSamples << std::endl;
+}
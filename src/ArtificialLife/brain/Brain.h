@@ -2,8 +2,10 @@
 #define _BRAIN_H_
 
 #include <ArtificialLife/brain/NeuronModel.h>
+#include <ArtificialLife/brain/ActivationFunction.h>
 #include <ArtificialLife/genome/BrainGenome.h>
 #include <AppLib/util/Random.h>
+#include <AppLib/util/BitSet.h>
 
 class NervousSystem;
 
@@ -92,10 +94,17 @@ public:
 
 	NeuronModel* GetNeuralNet() { return m_neuronModel; }
 
+	static void ReportSynapseFormatError(SynapseFormat format, int numBrains, int numTicks);
+	static void ReportActivationFunctionDrift(ActivationFunctionType type, int numBrains, int numTicks);
+
+	// Check the neuron search used while growing synapses against the
+	// original one it replaced. Returns the number of mismatches.
+	static int CheckNearestFreeNeuron(int numTrials);
+
 	int GetNumNeuralGroups() const { return m_numGroups; }
 
 private:
-	static int NearestFreeNeuron(int iin, bool* used, int num, int exclude);
+	static int NearestFreeNeuron(int iin, const BitSet& used, int exclude);
 
 	NervousSystem*	m_cns;
 	NeuronModel*	m_neuronModel;
@@ -103,6 +112,7 @@ private:
 	BrainGenome*	m_genome;
 
 	RandomNumberGenerator m_rng;
+	BitSet			m_neuronsUsed; // Reused while growing synapses from each group.
 
 };
 
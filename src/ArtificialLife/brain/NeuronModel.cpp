@@ -1,16 +1,56 @@
 #include "NeuronModel.h"
+#include "ActivationFunction.h"
 #include <AppLib/util/Random.h>
 #include <AppLib/math/MathLib.h>
+#include <algorithm>
+#include <assert.h>
 
 
 NeuronModel::Configuration NeuronModel::CONFIG;
 
 
+//-----------------------------------------------------------------------------
+// Compact synapse efficacies are stored as 16-bit fixed point numbers in the
+// range [-maxWeight, maxWeight].
+//-----------------------------------------------------------------------------
+
+static const float COMPACT_EFFICACY_ONE = 32767.0f;
+
+static inline float DecodeEfficacy(short value, float maxWeight)
+{
+	return ((float) value * (maxWeight / COMPACT_EFFICACY_ONE));
+}
+
+static inline short EncodeEfficacy(float efficacy, float maxWeight, bool inhibitory)
+{
+	// Round to the nearest value (the efficacy is already within +/-maxWeight).
+	float scaled = efficacy * (COMPACT_EFFICACY_ONE / maxWeight);
+	int value = (int) (scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+	if (value > 32767)
+		value = 32767;
+	else if (value < -32767)
+		value = -32767;
+
+	// Inhibitory efficacies are never zero, so they keep their sign.
+	if (inhibitory && value >= 0)
+		value = -1;
+	return (short) value;
+}
+
+
 NeuronModel::NeuronModel()
 	: m_neurons(NULL)
 	, m_prevNeuronActivations(NULL)
 	, m_currNeuronActivations(NULL)
-	, m_synapses(NULL)
+	, m_neuronOrder(NULL)
+	, m_neuronOrderInverse(NULL)
+	, m_synapseFormat(SYNAPSE_FORMAT_FLOAT)
+	, m_synapseFromNeurons(NULL)
+	, m_synapseEfficacies(NULL)
+	, m_compactFromNeurons(NULL)
+	, m_compactEfficacies(NULL)
+	, m_numLearningSynapses(0)
+	, m_updateKernel(&NeuronModel::UpdateFloat)
 {
 	CONFIG.sigmoidSlope	= 1.0f;
 	CONFIG.maxWeight	= 1.0f;
@@ -20,20 +60,13 @@ NeuronModel::NeuronModel()
 void NeuronModel::CopyFrom(const NeuronModel& copy)
 {
 	// Delete previously allocated buffers.
-	if (m_neurons)
-		delete [] m_neurons;
-	if (m_prevNeuronActivations)
-		delete [] m_prevNeuronActivations;
-	if (m_currNeuronActivations)
-		delete [] m_currNeuronActivations;
-	if (m_synapses)
-		delete [] m_synapses;
+	Free();
 
 	m_dimensions			= copy.m_dimensions;
-	m_neurons				= new Neuron[m_dimensions.numNeurons];
-	m_prevNeuronActivations	= new float[m_dimensions.numNeurons];
-	m_currNeuronActivations	= new float[m_dimensions.numNeurons];
-	m_synapses				= new Synapse[m_dimensions.numSynapses];
+	m_synapseFormat			= copy.m_synapseFormat;
+	m_numLearningSynapses	= copy.m_numLearningSynapses;
+	m_synapseRuns			= copy.m_synapseRuns;
+	Allocate();
 		
 	// Copy neurons and activations.
 	for (int i = 0; i < m_dimensions.numNeurons; i++)
@@ -41,151 +74,522 @@ void NeuronModel::CopyFrom(const NeuronModel& copy)
 		m_currNeuronActivations[i]	= copy.m_currNeuronActivations[i];
 		m_prevNeuronActivations[i]	= copy.m_prevNeuronActivations[i];
 		m_neurons[i]				= copy.m_neurons[i];
+		m_neuronOrder[i]			= copy.m_neuronOrder[i];
+		m_neuronOrderInverse[i]		= copy.m_neuronOrderInverse[i];
 	}
 	
 	// Copy synapses.
 	for (long i = 0; i < m_dimensions.numSynapses; i++)
 	{
-		m_synapses[i] = copy.m_synapses[i];
+		if (m_synapseFormat == SYNAPSE_FORMAT_COMPACT)
+		{
+			m_compactFromNeurons[i]		= copy.m_compactFromNeurons[i];
+			m_compactEfficacies[i]		= copy.m_compactEfficacies[i];
+		}
+		else
+		{
+			m_synapseFromNeurons[i]		= copy.m_synapseFromNeurons[i];
+			m_synapseEfficacies[i]		= copy.m_synapseEfficacies[i];
+		}
 	}
+
+	SelectUpdateKernel();
 }
 
 NeuronModel::~NeuronModel()
+{
+	Free();
+}
+
+void NeuronModel::Allocate()
+{
+	m_neurons				= new Neuron[m_dimensions.numNeurons];
+	m_prevNeuronActivations	= new float[m_dimensions.numNeurons];
+	m_currNeuronActivations	= new float[m_dimensions.numNeurons];
+	m_neuronOrder			= new int[m_dimensions.numNeurons];
+	m_neuronOrderInverse	= new int[m_dimensions.numNeurons];
+
+	if (m_synapseFormat == SYNAPSE_FORMAT_COMPACT)
+	{
+		m_compactFromNeurons	= new unsigned short[m_dimensions.numSynapses];
+		m_compactEfficacies		= new short[m_dimensions.numSynapses];
+	}
+	else
+	{
+		m_synapseFromNeurons	= new int[m_dimensions.numSynapses];
+		m_synapseEfficacies		= new float[m_dimensions.numSynapses];
+	}
+}
+
+void NeuronModel::Free()
 {
 	delete [] m_neurons; m_neurons = NULL;
 	delete [] m_prevNeuronActivations; m_prevNeuronActivations = NULL;
 	delete [] m_currNeuronActivations; m_currNeuronActivations = NULL;
-	delete [] m_synapses; m_synapses = NULL;
+	delete [] m_neuronOrder; m_neuronOrder = NULL;
+	delete [] m_neuronOrderInverse; m_neuronOrderInverse = NULL;
+	delete [] m_synapseFromNeurons; m_synapseFromNeurons = NULL;
+	delete [] m_synapseEfficacies; m_synapseEfficacies = NULL;
+	delete [] m_compactFromNeurons; m_compactFromNeurons = NULL;
+	delete [] m_compactEfficacies; m_compactEfficacies = NULL;
 }
 
 void NeuronModel::Init(const Dimensions& dimensions, float initialActivation)
 {
-	if (m_neurons)
-		delete [] m_neurons;
-	if (m_prevNeuronActivations)
-		delete [] m_prevNeuronActivations;
-	if (m_currNeuronActivations)
-		delete [] m_currNeuronActivations;
-	if (m_synapses)
-		delete [] m_synapses;
+	Free();
 
 	m_dimensions			= dimensions;
-	m_neurons				= new Neuron[m_dimensions.numNeurons];
-	m_prevNeuronActivations	= new float[m_dimensions.numNeurons];
-	m_currNeuronActivations	= new float[m_dimensions.numNeurons];
-	m_synapses				= new Synapse[m_dimensions.numSynapses];
+	m_synapseFormat			= SYNAPSE_FORMAT_FLOAT;
+	m_numLearningSynapses	= dimensions.numSynapses;
+	m_synapseRuns.clear();
+	Allocate();
 
 	for (int i = 0; i < m_dimensions.numNeurons; i++)
 	{
 		m_currNeuronActivations[i] = initialActivation;
 		m_prevNeuronActivations[i] = initialActivation;
+		m_neuronOrder[i] = i;
+		m_neuronOrderInverse[i] = i;
 	}
+
+	SelectUpdateKernel();
 }
 
-void NeuronModel::SetNeuron(int index, const NeuronAttrs& attributes, int startSynapse, int endSynapse)
+void NeuronModel::SetNeuron(int index, const NeuronAttrs& attributes, int startSynapse, int endSynapse, int startRun, int endRun)
 {
 	m_neurons[index].bias			= attributes.bias;
 	m_neurons[index].tau			= attributes.tau;
 	m_neurons[index].startSynapse	= startSynapse;
 	m_neurons[index].endSynapse		= endSynapse;
+	m_neurons[index].endLearningSynapse = endSynapse;
+	m_neurons[index].startRun		= startRun;
+	m_neurons[index].endRun			= endRun;
 }
 
-void NeuronModel::SetSynapse(int index, int fromNeuron, int toNeuron, float efficacy, float learningRate)
+void NeuronModel::SetSynapse(int index, int fromNeuron, float efficacy)
 {
-	m_synapses[index].fromNeuron	= fromNeuron;
-	m_synapses[index].toNeuron		= toNeuron;
-	m_synapses[index].efficacy		= efficacy;
-	m_synapses[index].learningRate	= learningRate;
+	m_synapseFromNeurons[index]		= fromNeuron;
+	m_synapseEfficacies[index]		= efficacy;
 }
 
-void NeuronModel::Update()
+void NeuronModel::AddSynapseRun(int startSynapse, int endSynapse, float learningRate)
 {
-	long k;
+	SynapseRun run;
+	run.startSynapse	= startSynapse;
+	run.endSynapse		= endSynapse;
+	run.learningRate	= learningRate;
+	m_synapseRuns.push_back(run);
+}
 
-	//-----------------------------------------------------------------------------
-	// Swap the prev and curr activation arrays.
+Synapse NeuronModel::GetSynapse(int synapseIndex) const
+{
+	Synapse synapse;
+	if (m_synapseFormat == SYNAPSE_FORMAT_COMPACT)
+	{
+		synapse.efficacy		= DecodeEfficacy(m_compactEfficacies[synapseIndex], CONFIG.maxWeight);
+		synapse.learningRate	= GetSynapseLearningRate(synapseIndex, synapse.efficacy);
+		synapse.fromNeuron		= m_neuronOrderInverse[m_compactFromNeurons[synapseIndex]];
+	}
+	else
+	{
+		synapse.efficacy		= m_synapseEfficacies[synapseIndex];
+		synapse.learningRate	= GetSynapseLearningRate(synapseIndex, synapse.efficacy);
+		synapse.fromNeuron		= m_neuronOrderInverse[m_synapseFromNeurons[synapseIndex]];
+	}
+	return synapse;
+}
 
-	float* tempActivations = m_currNeuronActivations;
-	m_currNeuronActivations = m_prevNeuronActivations;
-	m_prevNeuronActivations = tempActivations;
+// Find the learning rate of a synapse from the run containing it. Frozen
+// synapses are not part of any run.
+float NeuronModel::GetSynapseLearningRate(long synapseIndex, float efficacy) const
+{
+	int numRuns = (int) m_synapseRuns.size();
+	int low = 0;
+	int high = numRuns;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (m_synapseRuns[mid].endSynapse <= synapseIndex)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low < numRuns && m_synapseRuns[low].startSynapse <= synapseIndex)
+		return m_synapseRuns[low].learningRate;
+	return (efficacy < 0.0f ? -1.e-10f : 0.0f);
+}
 
-	//-----------------------------------------------------------------------------
-	// Update output neurons.
+long NeuronModel::GetSynapseMemoryUsage() const
+{
+	long bytesPerSynapse;
+	if (m_synapseFormat == SYNAPSE_FORMAT_COMPACT)
+		bytesPerSynapse = sizeof(unsigned short) + sizeof(short);
+	else
+		bytesPerSynapse = sizeof(int) + sizeof(float);
+	return (m_dimensions.numSynapses * bytesPerSynapse) +
+		((long) m_synapseRuns.size() * sizeof(SynapseRun));
+}
+
+float NeuronModel::GetLearningSynapseFraction() const
+{
+	if (m_dimensions.numSynapses == 0)
+		return 0.0f;
+	return ((float) m_numLearningSynapses / (float) m_dimensions.numSynapses);
+}
+
+// A synapse is frozen if the Hebbian update can never change its efficacy:
+// its learning rate is zero (inhibitory rates are clamped to -1e-10), and its
+// efficacy is small enough that it is not affected by the decay.
+bool NeuronModel::IsSynapseFrozen(float efficacy, float learningRate) const
+{
+	return (fabs(learningRate) <= 1.e-10f &&
+		fabs(efficacy) <= (0.5f * CONFIG.maxWeight));
+}
+
+// Reorder the internal neurons so that neurons which gather their inputs from
+// nearby neurons are stored next to each other. This must be called once after
+// all neurons and synapses have been set (and before the first update).
+//
+// Each internal neuron is keyed by the average index of the neurons it
+// receives synapses from, then the rows of the connection matrix are stored
+// in key order. Within each row, the learning synapses are moved in front of
+// the frozen ones so that the learning pass can skip the frozen synapses.
+void NeuronModel::OrderNeurons()
+{
+	assert(m_synapseFormat == SYNAPSE_FORMAT_FLOAT);
 
-	for (int i = m_dimensions.GetOutputNeuronsBegin(); i < m_dimensions.GetOutputNeuronsEnd(); i++)
+	int internalBegin	= m_dimensions.GetInternalNeuronsBegin();
+	int internalEnd		= m_dimensions.GetInternalNeuronsEnd();
+	int numInternal		= internalEnd - internalBegin;
+
+	// Compute the sort key for each internal neuron.
+	std::vector<std::pair<float, int>> keys(numInternal);
+	for (int i = internalBegin; i < internalEnd; i++)
 	{
-		// Add in the bias term.
-		float activation = m_neurons[i].bias;
+		const Neuron& neuron = m_neurons[i];
+		float key = (float) i;
+		if (neuron.endSynapse > neuron.startSynapse)
+		{
+			key = 0.0f;
+			for (int k = neuron.startSynapse; k < neuron.endSynapse; k++)
+				key += (float) m_synapseFromNeurons[k];
+			key /= (float) (neuron.endSynapse - neuron.startSynapse);
+		}
+		keys[i - internalBegin] = std::make_pair(key, i);
+	}
+	std::stable_sort(keys.begin(), keys.end(),
+		[](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first < b.first; });
 
-		// Sum up the inputs to this neuron times their synapse weights (efficacies).
-		for (k = m_neurons[i].startSynapse; k < m_neurons[i].endSynapse; k++)
+	// Build the new neuron order (input and output neurons are left in place).
+	for (int i = 0; i < numInternal; i++)
+	{
+		m_neuronOrder[keys[i].second] = internalBegin + i;
+		m_neuronOrderInverse[internalBegin + i] = keys[i].second;
+	}
+
+	// Rebuild the neurons and synapse rows in the new order.
+	Neuron*	neurons				= new Neuron[m_dimensions.numNeurons];
+	int*	synapseFromNeurons	= new int[m_dimensions.numSynapses];
+	float*	synapseEfficacies	= new float[m_dimensions.numSynapses];
+	std::vector<SynapseRun> synapseRuns;
+	synapseRuns.reserve(m_synapseRuns.size());
+
+	long synapseCounter = 0;
+	long numLearningSynapses = 0;
+
+	for (int i = 0; i < m_dimensions.numNeurons; i++)
+	{
+		const Neuron& neuron = m_neurons[m_neuronOrderInverse[i]];
+		neurons[i] = neuron;
+
+		if (i < m_dimensions.GetNonInputNeuronsBegin())
+			continue;
+
+		// Copy the learning synapses first (keeping them in their runs), then
+		// the frozen synapses.
+		neurons[i].startSynapse = synapseCounter;
+		neurons[i].startRun = (int) synapseRuns.size();
+		for (int pass = 0; pass < 2; pass++)
 		{
-			activation += m_synapses[k].efficacy *
-				m_prevNeuronActivations[m_synapses[k].fromNeuron];
+			for (int r = neuron.startRun; r < neuron.endRun; r++)
+			{
+				SynapseRun run = m_synapseRuns[r];
+				int runStart = synapseCounter;
+
+				for (int k = run.startSynapse; k < run.endSynapse; k++)
+				{
+					bool frozen = IsSynapseFrozen(m_synapseEfficacies[k], run.learningRate);
+					if (frozen != (pass == 1))
+						continue;
+					synapseFromNeurons[synapseCounter]	= m_neuronOrder[m_synapseFromNeurons[k]];
+					synapseEfficacies[synapseCounter]	= m_synapseEfficacies[k];
+					synapseCounter++;
+				}
+
+				if (pass == 0 && synapseCounter > runStart)
+				{
+					run.startSynapse = runStart;
+					run.endSynapse = synapseCounter;
+					synapseRuns.push_back(run);
+				}
+			}
+			if (pass == 0)
+			{
+				neurons[i].endLearningSynapse = synapseCounter;
+				numLearningSynapses += synapseCounter - neurons[i].startSynapse;
+			}
 		}
+		neurons[i].endSynapse = synapseCounter;
+		neurons[i].endRun = (int) synapseRuns.size();
+	}
+	m_numLearningSynapses = numLearningSynapses;
 
-		// Apply the sigmoid function to the resulting activation.
-		m_currNeuronActivations[i] = Sigmoid(activation, CONFIG.sigmoidSlope);
+	// Activations are reordered too.
+	std::vector<float> curr(m_currNeuronActivations, m_currNeuronActivations + m_dimensions.numNeurons);
+	std::vector<float> prev(m_prevNeuronActivations, m_prevNeuronActivations + m_dimensions.numNeurons);
+	for (int i = internalBegin; i < internalEnd; i++)
+	{
+		m_currNeuronActivations[i] = curr[m_neuronOrderInverse[i]];
+		m_prevNeuronActivations[i] = prev[m_neuronOrderInverse[i]];
 	}
-	
+
+	delete [] m_neurons;
+	delete [] m_synapseFromNeurons;
+	delete [] m_synapseEfficacies;
+	m_neurons				= neurons;
+	m_synapseFromNeurons	= synapseFromNeurons;
+	m_synapseEfficacies		= synapseEfficacies;
+	m_synapseRuns.swap(synapseRuns);
+
+	SelectUpdateKernel();
+}
+
+// Convert the synapses to the given storage format. Returns false if the
+// brain is too big to be stored in the compact format.
+bool NeuronModel::SetSynapseFormat(SynapseFormat format)
+{
+	if (format == m_synapseFormat)
+		return true;
+
+	long numSynapses = m_dimensions.numSynapses;
+
+	if (format == SYNAPSE_FORMAT_COMPACT)
+	{
+		if (m_dimensions.numNeurons > 65536)
+			return false;
+
+		m_compactFromNeurons	= new unsigned short[numSynapses];
+		m_compactEfficacies		= new short[numSynapses];
+		for (long k = 0; k < numSynapses; k++)
+		{
+			m_compactFromNeurons[k]	= (unsigned short) m_synapseFromNeurons[k];
+			m_compactEfficacies[k]	= EncodeEfficacy(m_synapseEfficacies[k],
+				CONFIG.maxWeight, m_synapseEfficacies[k] < 0.0f);
+		}
+
+		delete [] m_synapseFromNeurons; m_synapseFromNeurons = NULL;
+		delete [] m_synapseEfficacies; m_synapseEfficacies = NULL;
+	}
+	else
+	{
+		m_synapseFromNeurons	= new int[numSynapses];
+		m_synapseEfficacies		= new float[numSynapses];
+		for (long k = 0; k < numSynapses; k++)
+		{
+			m_synapseFromNeurons[k]	= m_compactFromNeurons[k];
+			m_synapseEfficacies[k]	= DecodeEfficacy(m_compactEfficacies[k], CONFIG.maxWeight);
+		}
+
+		delete [] m_compactFromNeurons; m_compactFromNeurons = NULL;
+		delete [] m_compactEfficacies; m_compactEfficacies = NULL;
+	}
+
+	m_synapseFormat = format;
+	SelectUpdateKernel();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Update kernel
+//-----------------------------------------------------------------------------
+
+// The synapse arrays of each format are wrapped in these structs so that the
+// update kernel can be written once and specialized per format.
+
+struct FloatSynapseArrays
+{
+	const int*	fromNeurons;
+	float*		efficacies;
+
+	inline float GetEfficacy(long k) const
+	{
+		return efficacies[k];
+	}
+
+	inline void SetEfficacy(long k, float efficacy, bool inhibitory) const
+	{
+		efficacies[k] = efficacy;
+	}
+};
+
+struct CompactSynapseArrays
+{
+	const unsigned short*	fromNeurons;
+	short*					efficacies;
+	float					maxWeight;
+
+	inline float GetEfficacy(long k) const
+	{
+		return DecodeEfficacy(efficacies[k], maxWeight);
+	}
+
+	inline void SetEfficacy(long k, float efficacy, bool inhibitory) const
+	{
+		efficacies[k] = EncodeEfficacy(efficacy, maxWeight, inhibitory);
+	}
+};
+
+// Apply Hebbian learning to a run of synapses which share the same learning
+// rate and type.
+template <bool T_Inhibitory, class T_Synapses>
+static inline void LearnSynapseRun(const T_Synapses& synapses, const SynapseRun& run, float rate,
+								   const float* prevActivations, float maxWeight, float decayRate)
+{
+	const float halfMaxWeight = 0.5f * maxWeight;
+	const float decay = 1.0f - decayRate;
+
+	for (long k = run.startSynapse; k < run.endSynapse; k++)
+	{
+		// Hebbian learning.
+		float efficacy = synapses.GetEfficacy(k) + rate
+			* (prevActivations[synapses.fromNeurons[k]] - 0.5f);
+				
+		// Gradually decay synapse efficacy.
+		if (fabs(efficacy) > halfMaxWeight)
+		{
+			efficacy *= 1.0f - decay * (fabs(efficacy) - halfMaxWeight) / halfMaxWeight;
+			if (efficacy > maxWeight)
+				efficacy = maxWeight;
+			else if (efficacy < -maxWeight)
+				efficacy = -maxWeight;
+		}
+		else
+		{
+			// not strictly correct for this to be in an else clause,
+			// but if lrate is reasonable, efficacy should never change
+			// sign with a new magnitude greater than 0.5 * Brain::config.maxWeight
+			if (T_Inhibitory)
+				efficacy = Math::Min(-1.e-10f, efficacy);
+			else
+				efficacy = Math::Max(0.0f, efficacy);
+		}
+		
+		synapses.SetEfficacy(k, efficacy, T_Inhibitory);
+	}
+}
+
+// The member arrays are read into locals first, so the compiler doesn't
+// have to reload them after every store to the activation and synapse arrays.
+template <class T_Synapses>
+void NeuronModel::UpdateSynapses(const T_Synapses& synapses)
+{
+	const int		nonInputBegin	= m_dimensions.GetNonInputNeuronsBegin();
+	const int		nonInputEnd		= m_dimensions.GetNonInputNeuronsEnd();
+	const Neuron*	neurons			= m_neurons;
+	float*			currActivations	= m_currNeuronActivations;
+	const float*	prevActivations	= m_prevNeuronActivations;
+
 	//-----------------------------------------------------------------------------
-	// Update internal neurons.
+	// Update output and internal neurons (one row of the connection matrix each).
 
-	for (int i = m_dimensions.GetInternalNeuronsBegin(); i < m_dimensions.GetInternalNeuronsEnd(); i++)
+	for (int i = nonInputBegin; i < nonInputEnd; i++)
 	{
+		const int rowEnd = neurons[i].endSynapse;
+
 		// Add in the bias term.
-		float activation = m_neurons[i].bias;
+		float activation = neurons[i].bias;
 
 		// Sum up the inputs to this neuron times their synapse weights (efficacies).
-		for (k = m_neurons[i].startSynapse; k < m_neurons[i].endSynapse; k++)
+		for (long k = neurons[i].startSynapse; k < rowEnd; k++)
 		{
-			activation += m_synapses[k].efficacy *
-				m_prevNeuronActivations[m_synapses[k].fromNeuron];
+			activation += synapses.GetEfficacy(k) *
+				prevActivations[synapses.fromNeurons[k]];
 		}
 
-		// Apply the sigmoid function to the resulting activation.
-		m_currNeuronActivations[i] = Sigmoid(activation, CONFIG.sigmoidSlope);
+		currActivations[i] = activation;
 	}
+
+	// Apply the sigmoid function to the resulting activations.
+	ActivationFunction::Apply(currActivations + nonInputBegin,
+		nonInputEnd - nonInputBegin, CONFIG.sigmoidSlope);
 	
 	//-----------------------------------------------------------------------------
-	// Update learning for all synapses.
+	// Update learning for all synapses, row by row (frozen synapses are
+	// stored at the end of each row and are skipped).
+
+	const SynapseRun* runs = (m_synapseRuns.empty() ? NULL : &m_synapseRuns[0]);
+	const float maxWeight = CONFIG.maxWeight;
+	const float decayRate = CONFIG.decayRate;
 
-	for (k = 0; k < m_dimensions.numSynapses; k++)
+	for (int i = nonInputBegin; i < nonInputEnd; i++)
 	{
-		Synapse& synapse = m_synapses[k];
+		// The post-synaptic term is the same for the whole row.
+		float activationTo = currActivations[i] - 0.5f;
 
-		// Hebbian learning.
-		float efficacy = synapse.efficacy + synapse.learningRate
-			* (m_currNeuronActivations[synapse.toNeuron] - 0.5f)
-			* (m_prevNeuronActivations[synapse.fromNeuron] - 0.5f);
-				
-		// Gradually decay synapse efficacy.
-        if (fabs(efficacy) > (0.5f * CONFIG.maxWeight))
-        {
-            efficacy *= 1.0f - (1.0f - CONFIG.decayRate) *
-                (fabs(efficacy) - 0.5f * CONFIG.maxWeight) / (0.5f * CONFIG.maxWeight);
-            if (efficacy > CONFIG.maxWeight)
-                efficacy = CONFIG.maxWeight;
-            else if (efficacy < -CONFIG.maxWeight)
-                efficacy = -CONFIG.maxWeight;
-        }
-        else
-        {
-            // not strictly correct for this to be in an else clause,
-            // but if lrate is reasonable, efficacy should never change
-            // sign with a new magnitude greater than 0.5 * Brain::config.maxWeight
-            if (synapse.learningRate >= 0.0f)  // excitatory
-                efficacy = Math::Max(0.0f, efficacy);
-            if (synapse.learningRate < 0.0f)  // inhibitory
-                efficacy = Math::Min(-1.e-10f, efficacy);
-        }
-		
-		synapse.efficacy = efficacy;
-		
+		for (int r = neurons[i].startRun; r < neurons[i].endRun; r++)
+		{
+			const SynapseRun& run = runs[r];
+
+			// The learning rate and the post-synaptic term are constant for
+			// the whole run.
+			float rate = run.learningRate * activationTo;
+
+			if (run.learningRate < 0.0f)
+				LearnSynapseRun<true>(synapses, run, rate, prevActivations, maxWeight, decayRate);
+			else
+				LearnSynapseRun<false>(synapses, run, rate, prevActivations, maxWeight, decayRate);
+		}
 	}
 }
 
-float NeuronModel::Sigmoid(float x, float slope)
+void NeuronModel::UpdateFloat()
+{
+	FloatSynapseArrays synapses;
+	synapses.fromNeurons	= m_synapseFromNeurons;
+	synapses.efficacies		= m_synapseEfficacies;
+	UpdateSynapses(synapses);
+}
+
+void NeuronModel::UpdateCompact()
 {
-    return (1.0f / (1.0f + expf(-x * slope)));
+	CompactSynapseArrays synapses;
+	synapses.fromNeurons	= m_compactFromNeurons;
+	synapses.efficacies		= m_compactEfficacies;
+	synapses.maxWeight		= CONFIG.maxWeight;
+	UpdateSynapses(synapses);
+}
+
+// Pick the update kernel for the synapse format. This must be called
+// whenever the brain's structure or synapse format changes.
+void NeuronModel::SelectUpdateKernel()
+{
+	if (m_synapseFormat == SYNAPSE_FORMAT_COMPACT)
+		m_updateKernel = &NeuronModel::UpdateCompact;
+	else
+		m_updateKernel = &NeuronModel::UpdateFloat;
+}
+
+void NeuronModel::Update()
+{
+	//-----------------------------------------------------------------------------
+	// Swap the prev and curr activation arrays.
+
+	float* tempActivations = m_currNeuronActivations;
+	m_currNeuronActivations = m_prevNeuronActivations;
+	m_prevNeuronActivations = tempActivations;
+
+	//-----------------------------------------------------------------------------
+	// Update the neurons and synapses with the kernel for the synapse format.
+
+	(this->*m_updateKernel)();
 }
@@ -16,12 +16,21 @@ float Sigmoid(float x, float slope);
 // and new blocks of memory can simply be repointered rather than
 // copied.
 
+// The synapses going to a neuron are stored contiguously (one row of the
+// sparse connection matrix), so startSynapse and endSynapse act as the row
+// pointers of the CSR synapse arrays. Within a row, the synapses which can
+// learn come first, up to endLearningSynapse. These are grouped into runs
+// (startRun to endRun), one for each group and synapse type they come from.
+
 struct Neuron
 {
 	float	bias;
 	float	tau; // ???
 	int		startSynapse;
 	int		endSynapse;
+	int		endLearningSynapse;
+	int		startRun;
+	int		endRun;
 };
 
 
@@ -50,12 +59,32 @@ struct NeuronAttrs
 // Synapse
 //-----------------------------------------------------------------------------
 
+// Synapses are stored by the neuron model as separate arrays (column indices,
+// efficacies and learning rates), this struct is only used to inspect a single
+// synapse. The target neuron is implied by the row the synapse belongs to.
+
 struct Synapse
 {
 	float	efficacy; // > 0 for excitatory, < 0 for inhibitory
 	float	learningRate;
 	int		fromNeuron;
-	int		toNeuron;
+};
+
+// A contiguous range of synapses to a neuron which all come from the same
+// neuron group and synapse type, so they share the same learning rate. The
+// sign of the learning rate tells the type (negative for inhibitory).
+struct SynapseRun
+{
+	int		startSynapse;
+	int		endSynapse;
+	float	learningRate;
+};
+
+// How synapse efficacies and indices are stored.
+enum SynapseFormat
+{
+	SYNAPSE_FORMAT_FLOAT = 0,	// 32-bit indices and efficacies.
+	SYNAPSE_FORMAT_COMPACT,		// 16-bit indices, 16-bit fixed point efficacies.
 };
 
 
@@ -125,24 +154,48 @@ public:
 	void CopyFrom(const NeuronModel& copy);
 
 	void Init(const Dimensions& dimensions, float initialActivation = 0.0f);
-	void SetNeuron(int index, const NeuronAttrs& attributes, int startSynapses, int endSynapses);
-	void SetSynapse(int index, int fromNeuron, int toNeuron, float efficacy, float learningRate);
+	void SetNeuron(int index, const NeuronAttrs& attributes, int startSynapses, int endSynapses, int startRun = 0, int endRun = 0);
+	void SetSynapse(int index, int fromNeuron, float efficacy);
+	void AddSynapseRun(int startSynapse, int endSynapse, float learningRate);
+	void OrderNeurons();
+	bool SetSynapseFormat(SynapseFormat format);
 	void Update();
 
-	float GetNeuronActivation(int neuronIndex)			const { return m_currNeuronActivations[neuronIndex]; }
-	float GetNeuronActivationPrev(int neuronIndex)		const { return m_prevNeuronActivations[neuronIndex]; }
-	const Neuron&		GetNeuron(int neuronIndex)		const { return m_neurons[neuronIndex]; }
-	const Synapse&		GetSynapse(int synapseIndex)	const { return m_synapses[synapseIndex]; }
+	// Neuron indices passed to these methods are the indices the neurons were
+	// grown with. Internally, neurons may be stored in a different order (see
+	// OrderNeurons), but input and output neurons always keep their indices so
+	// that nerves can address the activations buffer directly.
+
+	float GetNeuronActivation(int neuronIndex)			const { return m_currNeuronActivations[m_neuronOrder[neuronIndex]]; }
+	float GetNeuronActivationPrev(int neuronIndex)		const { return m_prevNeuronActivations[m_neuronOrder[neuronIndex]]; }
+	const Neuron&		GetNeuron(int neuronIndex)		const { return m_neurons[m_neuronOrder[neuronIndex]]; }
+	Synapse				GetSynapse(int synapseIndex)	const;
 	const Dimensions&	GetDimensions()					const { return m_dimensions; }
+	long				GetNumLearningSynapses()		const { return m_numLearningSynapses; }
+	float				GetLearningSynapseFraction()	const;
+	SynapseFormat		GetSynapseFormat()				const { return m_synapseFormat; }
+	int					GetNumSynapseRuns()				const { return (int) m_synapseRuns.size(); }
+	long				GetSynapseMemoryUsage()			const;
 
 	void SetDimensions(const Dimensions& dims)						{ m_dimensions = dims; }
-	void SetNeuronActivation(int neuronIndex, float activation)		{ m_currNeuronActivations[neuronIndex] = activation; }
-	void SetNeuronActivationPrev(int neuronIndex, float activation)	{ m_prevNeuronActivations[neuronIndex] = activation; }
+	void SetNeuronActivation(int neuronIndex, float activation)		{ m_currNeuronActivations[m_neuronOrder[neuronIndex]] = activation; }
+	void SetNeuronActivationPrev(int neuronIndex, float activation)	{ m_prevNeuronActivations[m_neuronOrder[neuronIndex]] = activation; }
 	
 	float** GetActivationsBuffer() { return &m_currNeuronActivations; }
 
 private:
-	float Sigmoid(float x, float slope);
+	void Allocate();
+	void Free();
+	bool IsSynapseFrozen(float efficacy, float learningRate) const;
+	float GetSynapseLearningRate(long synapseIndex, float efficacy) const;
+
+	template <class T_Synapses>
+	void UpdateSynapses(const T_Synapses& synapses);
+	void UpdateFloat();
+	void UpdateCompact();
+	void SelectUpdateKernel();
+
+	typedef void (NeuronModel::*UpdateKernel)();
 
 	static Configuration CONFIG;
 
@@ -150,7 +203,21 @@ private:
 	Neuron*			m_neurons;
 	float*			m_prevNeuronActivations;
 	float*			m_currNeuronActivations;
-	Synapse*		m_synapses;
+	int*			m_neuronOrder;			// Maps grown neuron indices to stored neuron indices.
+	int*			m_neuronOrderInverse;	// Maps stored neuron indices to grown neuron indices.
+
+	// Synapses in CSR format (rows are given by the neurons' start/end synapses).
+	// Only the arrays for the current synapse format are allocated.
+	SynapseFormat	m_synapseFormat;
+	int*			m_synapseFromNeurons;
+	float*			m_synapseEfficacies;
+	unsigned short*	m_compactFromNeurons;
+	short*			m_compactEfficacies;
+	long			m_numLearningSynapses;
+
+	std::vector<SynapseRun> m_synapseRuns;
+
+	UpdateKernel	m_updateKernel; // Specialized for the synapse format.
 };
 
 
@@ -0,0 +1,160 @@
+#include "FoodField.h"
+#include <AppLib/math/MathLib.h>
+#include <AppLib/util/Random.h>
+#include <AppLib/util/Morton.h>
+
+
+static const float FOOD_MIN_SIZE = 0.4f;
+static const float FOOD_MAX_SIZE = 4.0f;
+
+
+FoodField::FoodField()
+	: m_cellSize(1.0f)
+	, m_gridWidth(0)
+	, m_gridHeight(0)
+{
+}
+
+void FoodField::Initialize(int numSites, int numPatches, float patchRadius,
+						   float worldWidth, float worldHeight, bool mortonOrder)
+{
+	m_x.resize(numSites);
+	m_y.resize(numSites);
+	m_size.assign(numSites, 0.0f);
+
+	// All sites start depleted.
+	m_depleted.resize(numSites);
+	for (int i = 0; i < numSites; i++)
+		m_depleted[i] = i;
+
+	// Place the patches.
+	m_patches.resize(Math::Max(0, numPatches));
+	for (unsigned int i = 0; i < m_patches.size(); i++)
+	{
+		m_patches[i].radius = patchRadius;
+		m_patches[i].center = Vector2f(
+			Random::NextFloat() * worldWidth,
+			Random::NextFloat() * worldHeight);
+	}
+
+	// Place the sites, dealing them out to the patches in turn.
+	for (int i = 0; i < numSites; i++)
+	{
+		Vector2f pos;
+		if (m_patches.empty())
+		{
+			pos = Vector2f(Random::NextFloat() * worldWidth,
+						   Random::NextFloat() * worldHeight);
+		}
+		else
+		{
+			const FoodPatch& patch = m_patches[i % m_patches.size()];
+			float angle = Random::NextFloat() * Math::TWO_PI;
+			float dist = Math::Sqrt(Random::NextFloat()) * patch.radius;
+			pos.x = patch.center.x + (Math::Cos(angle) * dist);
+			pos.y = patch.center.y + (Math::Sin(angle) * dist);
+			pos.x = Math::Clamp(pos.x, 0.0f, worldWidth);
+			pos.y = Math::Clamp(pos.y, 0.0f, worldHeight);
+		}
+		m_x[i] = pos.x;
+		m_y[i] = pos.y;
+	}
+
+	// Store the sites in Morton order, so nearby sites are near each other
+	// in memory.
+	if (mortonOrder)
+	{
+		MortonSorter sorter;
+		sorter.Begin(numSites, worldWidth, worldHeight);
+		for (int i = 0; i < numSites; i++)
+			sorter.SetPoint(i, m_x[i], m_y[i]);
+		const std::vector<int>& order = sorter.Sort();
+		std::vector<float> unsortedX(m_x);
+		std::vector<float> unsortedY(m_y);
+		for (int i = 0; i < numSites; i++)
+		{
+			m_x[i] = unsortedX[order[i]];
+			m_y[i] = unsortedY[order[i]];
+		}
+	}
+
+	// Build the grid, with cells as wide as the largest food.
+	m_cellSize = GetRadius(FOOD_MAX_SIZE) * 2.0f;
+	m_gridWidth = Math::Max(1, (int) Math::Ceil(worldWidth / m_cellSize));
+	m_gridHeight = Math::Max(1, (int) Math::Ceil(worldHeight / m_cellSize));
+	int numCells = m_gridWidth * m_gridHeight;
+
+	std::vector<int> siteCells(numSites);
+	m_cellStart.assign(numCells + 1, 0);
+	for (int i = 0; i < numSites; i++)
+	{
+		siteCells[i] = (GetCellY(m_y[i]) * m_gridWidth) + GetCellX(m_x[i]);
+		m_cellStart[siteCells[i] + 1]++;
+	}
+	for (int i = 0; i < numCells; i++)
+		m_cellStart[i + 1] += m_cellStart[i];
+
+	std::vector<int> cellEnd(m_cellStart.begin(), m_cellStart.end() - 1);
+	m_cellSites.resize(numSites);
+	for (int i = 0; i < numSites; i++)
+		m_cellSites[cellEnd[siteCells[i]]++] = i;
+}
+
+bool FoodField::RegrowRandomSite(float size)
+{
+	if (m_depleted.empty())
+		return false;
+
+	int index = Random::NextInt(0, (int) m_depleted.size());
+	int site = m_depleted[index];
+	m_depleted[index] = m_depleted.back();
+	m_depleted.pop_back();
+
+	m_size[site] = Math::Clamp(size, FOOD_MIN_SIZE, FOOD_MAX_SIZE);
+	return true;
+}
+
+float FoodField::Eat(int site, float amount)
+{
+	float& size = m_size[site];
+	amount = Math::Min(amount, size);
+	size -= amount;
+
+	// Eat the rest of the food if there isn't much left.
+	if (size < FOOD_MIN_SIZE)
+	{
+		amount += Math::Max(0.0f, size);
+		size = 0.0f;
+		m_depleted.push_back(site);
+	}
+
+	return amount; // Each unit of food gives one unit of energy.
+}
+
+float FoodField::GetRadius(float size)
+{
+	return Math::Lerp(
+		FOOD_MAX_SIZE * 5.0f * 0.3f,
+		FOOD_MAX_SIZE * 5.0f,
+		size / FOOD_MAX_SIZE);
+}
+
+float FoodField::GetMinSize()
+{
+	return FOOD_MIN_SIZE;
+}
+
+float FoodField::GetMaxSize()
+{
+	return FOOD_MAX_SIZE;
+}
+
+int FoodField::GetCellX(float x) const
+{
+	return Math::Clamp((int) (x / m_cellSize), 0, m_gridWidth - 1);
+}
+
+int FoodField::GetCellY(float y) const
+{
+	return Math::Clamp((int) (y / m_cellSize), 0, m_gridHeight - 1);
+}
@@ -0,0 +1,114 @@
+#ifndef _FOOD_FIELD_H_
+#define _FOOD_FIELD_H_
+
+#include <AppLib/math/Vector2f.h>
+#include <vector>
+
+
+// A region of the world which food sites are clustered in.
+struct FoodPatch
+{
+	Vector2f	center;
+	float		radius;
+};
+
+
+//-----------------------------------------------------------------------------
+// FoodField - a fixed set of sites where food grows. The sites are placed
+// once, either spread uniformly over the world or clustered in patches, and
+// never move. When the food at a site is eaten up, the site lies depleted
+// until it regrows in place. Because the sites never move, the grid used to
+// find food near an agent is built once, and the sites are stored in Morton
+// order so that the sites in each cell are close together in memory.
+//-----------------------------------------------------------------------------
+class FoodField
+{
+public:
+	FoodField();
+
+	// Place the sites and build the grid. All sites start depleted. With no
+	// patches, the sites are spread over the whole world. The sites are only
+	// left in the order they were placed to measure what Morton order gains.
+	void Initialize(int numSites, int numPatches, float patchRadius,
+					float worldWidth, float worldHeight, bool mortonOrder = true);
+
+	// Regrow a random depleted site to the given size. Returns false if no
+	// sites are depleted.
+	bool RegrowRandomSite(float size);
+
+	// Eat from the food at a site, returning the energy gained.
+	float Eat(int site, float amount);
+
+	int			GetNumSites()			const { return (int) m_size.size(); }
+	int			GetNumActive()			const { return GetNumSites() - (int) m_depleted.size(); }
+	bool		IsActive(int site)		const { return (m_size[site] > 0.0f); }
+	Vector2f	GetPosition(int site)	const { return Vector2f(m_x[site], m_y[site]); }
+	float		GetSize(int site)		const { return m_size[site]; }
+	float		GetRadius(int site)		const { return GetRadius(m_size[site]); }
+
+	const std::vector<FoodPatch>& GetPatches() const { return m_patches; }
+
+	// The radius that food of the given size can be eaten from.
+	static float GetRadius(float size);
+	static float GetMinSize();
+	static float GetMaxSize();
+
+	// Call func(site) for every active site whose food is within the given
+	// distance of a position (measured to the edge of the food's radius).
+	template <class T_Func>
+	void ForEachSiteNear(const Vector2f& pos, float distance, const T_Func& func);
+
+private:
+	int GetCellX(float x) const;
+	int GetCellY(float y) const;
+
+	// Site data, stored as a structure of arrays.
+	std::vector<float>		m_x;
+	std::vector<float>		m_y;
+	std::vector<float>		m_size;
+	std::vector<int>		m_depleted;		// Indices of the depleted sites.
+
+	std::vector<FoodPatch>	m_patches;
+
+	// Uniform grid over the sites, stored as one list of site indices sorted
+	// by cell.
+	float					m_cellSize;
+	int						m_gridWidth;
+	int						m_gridHeight;
+	std::vector<int>		m_cellStart;	// Where each cell's sites begin in m_cellSites.
+	std::vector<int>		m_cellSites;
+};
+
+
+template <class T_Func>
+void FoodField::ForEachSiteNear(const Vector2f& pos, float distance, const T_Func& func)
+{
+	float reach = distance + GetRadius(GetMaxSize());
+	int minX = GetCellX(pos.x - reach);
+	int maxX = GetCellX(pos.x + reach);
+	int minY = GetCellY(pos.y - reach);
+	int maxY = GetCellY(pos.y + reach);
+
+	for (int cy = minY; cy <= maxY; cy++)
+	{
+		for (int cx = minX; cx <= maxX; cx++)
+		{
+			int cell = (cy * m_gridWidth) + cx;
+			for (int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++)
+			{
+				int site = m_cellSites[i];
+				if (!IsActive(site))
+					continue;
+
+				float dx = m_x[site] - pos.x;
+				float dy = m_y[site] - pos.y;
+				float maxDist = distance + GetRadius(site);
+				if ((dx * dx) + (dy * dy) < maxDist * maxDist)
+					func(site);
+			}
+		}
+	}
+}
+
+
+#endif // _FOOD_FIELD_H_
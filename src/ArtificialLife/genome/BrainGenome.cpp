@@ -2,30 +2,46 @@
 #include <ArtificialLife/brain/Brain.h>
 #include <ArtificialLife/Simulation.h>
 #include <AppLib/math/MathLib.h>
+#include <algorithm>
 #include <assert.h>
 
 
+int BrainGenome::s_numGroups			= 0;
+int BrainGenome::s_groupGenesBegin		= 0;
+int BrainGenome::s_synapseGenesBegin	= 0;
+int BrainGenome::s_genomeSize			= 0;
+
+
 //-----------------------------------------------------------------------------
 // Constructor & destructor.
 //-----------------------------------------------------------------------------
 
 BrainGenome::BrainGenome()
+	: m_isDecoded(false)
 {
-	int numGroups = Simulation::PARAMS.numInputNeurGroups +
-					Simulation::PARAMS.numOutputNeurGroups +
-					Simulation::PARAMS.maxInternalNeuralGroups;
-
-	int genomeSize = NUM_PHYSIOLOGICAL_GENES +
-		(numGroups * NUM_GROUP_GENES) +
-		(numGroups * numGroups * NUM_SYNAPSE_TYPES * NUM_SYNAPSE_GENES);
+	// Compute the layout if nobody has yet.
+	if (s_genomeSize == 0)
+		InitializeLayout();
 
-	InitSize(genomeSize);
+	InitSize(s_genomeSize);
 }
 
 BrainGenome::~BrainGenome()
 {
 }
 
+void BrainGenome::InitializeLayout()
+{
+	s_numGroups = Simulation::PARAMS.numInputNeurGroups +
+				  Simulation::PARAMS.numOutputNeurGroups +
+				  Simulation::PARAMS.maxInternalNeuralGroups;
+
+	s_groupGenesBegin	= NUM_PHYSIOLOGICAL_GENES;
+	s_synapseGenesBegin	= s_groupGenesBegin + (s_numGroups * NUM_GROUP_GENES);
+	s_genomeSize		= s_synapseGenesBegin +
+		(s_numGroups * s_numGroups * NUM_SYNAPSE_TYPES * NUM_SYNAPSE_GENES);
+}
+
 
 //-----------------------------------------------------------------------------
 // Gene Access.
@@ -122,20 +138,14 @@ int BrainGenome::GetNumInternalNeuralGroups()
 
 Gene BrainGenome::GetGroupGene(GeneIndex gene, int group)
 {
-	int offset = NUM_PHYSIOLOGICAL_GENES + (group * NUM_GROUP_GENES) + gene;
+	int offset = s_groupGenesBegin + (group * NUM_GROUP_GENES) + gene;
 	return GetGene(offset);
 }
 
 Gene BrainGenome::GetSynapseGene(GeneIndex gene, int groupFrom, int groupTo, SynapseType synapseType)
 {
-	int numGroups = Simulation::PARAMS.numInputNeurGroups +
-					Simulation::PARAMS.numOutputNeurGroups +
-					Simulation::PARAMS.maxInternalNeuralGroups;
-
-	int offset = NUM_PHYSIOLOGICAL_GENES + (numGroups * NUM_GROUP_GENES) +
-				 ((groupFrom * numGroups  * NUM_SYNAPSE_TYPES) +
-				 (groupTo * NUM_SYNAPSE_TYPES) + (synapseType))  * NUM_SYNAPSE_GENES;
-
+	int offset = s_synapseGenesBegin +
+				 ((((groupFrom * s_numGroups) + groupTo) * NUM_SYNAPSE_TYPES) + synapseType) * NUM_SYNAPSE_GENES;
 	return GetGene(offset + gene);
 }
 
@@ -156,27 +166,31 @@ BrainGenome::NeurGroupInfo BrainGenome::GetGroupInfo(int group)
 
 BrainGenome::NeurGroupSynapseInfo BrainGenome::GetSynapseInfo(int groupFrom, int groupTo, SynapseType synapseType)
 {
-	NeurGroupSynapseInfo synapseInfo;
-	synapseInfo.connectionDensity = GetSynapseGene(
-		GENE_CONNECTION_DENSITY, groupFrom, groupTo, synapseType).AsFloat(
-		Simulation::PARAMS.minConnectionDensity,
-		Simulation::PARAMS.maxConnectionDensity);
-	synapseInfo.topologicalDistortion = GetSynapseGene(
-		GENE_TOPOLOGICAL_DISTORTION, groupFrom, groupTo, synapseType).AsFloat(
-		Simulation::PARAMS.minTopologicalDistortion,
-		Simulation::PARAMS.maxTopologicalDistortion);
-	synapseInfo.synapseLearningRate = GetSynapseGene(
-		GENE_SYNAPSE_LEARNING_RATE, groupFrom, groupTo, synapseType).AsFloat(
-		Simulation::PARAMS.minSynapseLearningRate,
-		Simulation::PARAMS.maxSynapseLearningRate);
+	if (!m_isDecoded)
+		DecodeNeurogenetics();
+	return m_synapseInfos[(((groupFrom * s_numGroups) + groupTo) * NUM_SYNAPSE_TYPES) + synapseType];
+}
 
-	// Negate learning rate for inhibitory neurons.
-	if (GetSynapseNeuronType_From(synapseType) == NEURON_TYPE_INHIBITORY)
-	{
-		synapseInfo.synapseLearningRate = Math::Min(-1.e-10f, -synapseInfo.synapseLearningRate);
-	}
+int BrainGenome::GetNeuronCount(NeuronType neuronType, int group)
+{
+	if (!m_isDecoded)
+		DecodeNeurogenetics();
+	return m_neuronCounts[(group * 2) + neuronType];
+}
 
-	return synapseInfo;
+int BrainGenome::GetSynapseCount(int groupFrom, int groupTo)
+{
+	if (!m_isDecoded)
+		DecodeNeurogenetics();
+	const int* counts = &m_synapseCounts[((groupFrom * s_numGroups) + groupTo) * NUM_SYNAPSE_TYPES];
+	return (counts[SYNAPSE_EE] + counts[SYNAPSE_EI] + counts[SYNAPSE_II] + counts[SYNAPSE_IE]);
+}
+
+int BrainGenome::GetSynapseCount(int groupFrom, int groupTo, SynapseType synapseType)
+{
+	if (!m_isDecoded)
+		DecodeNeurogenetics();
+	return m_synapseCounts[(((groupFrom * s_numGroups) + groupTo) * NUM_SYNAPSE_TYPES) + synapseType];
 }
 
 bool BrainGenome::IsOutputGroup(int group)
@@ -186,45 +200,99 @@ bool BrainGenome::IsOutputGroup(int group)
 }
 
 
-int BrainGenome::GetNeuronCount(NeuronType neuronType, int group)
+//-----------------------------------------------------------------------------
+// Neurogenetics decoding.
+//-----------------------------------------------------------------------------
+
+// Decode the neuron counts, synapse counts and synapse infos of every group
+// (and pair of groups) at once, so that growing a brain doesn't have to
+// decode the same genes over and over.
+void BrainGenome::DecodeNeurogenetics()
 {
-	if (group < Simulation::PARAMS.numInputNeurGroups + Simulation::PARAMS.numOutputNeurGroups)
+	int numInOutGroups = Simulation::PARAMS.numInputNeurGroups + Simulation::PARAMS.numOutputNeurGroups;
+
+	m_neuronCounts.resize(s_numGroups * 2);
+	m_synapseCounts.resize(s_numGroups * s_numGroups * NUM_SYNAPSE_TYPES);
+	m_synapseInfos.resize(s_numGroups * s_numGroups * NUM_SYNAPSE_TYPES);
+
+	// Neuron counts.
+	for (int group = 0; group < s_numGroups; group++)
 	{
-		if (group == 0)
-			return GetNumRedNeurons();
-		else if (group == 1)
-			return GetNumGreenNeurons();
-		else if (group == 2)
-			return GetNumBlueNeurons();
+		int* counts = &m_neuronCounts[group * 2];
+
+		if (group < numInOutGroups)
+		{
+			// Input and output groups don't distinguish inhibitory from excitatory.
+			int count = 1;
+			if (group == 0)
+				count = GetNumRedNeurons();
+			else if (group == 1)
+				count = GetNumGreenNeurons();
+			else if (group == 2)
+				count = GetNumBlueNeurons();
+			counts[NEURON_TYPE_EXCITATORY] = count;
+			counts[NEURON_TYPE_INHIBITORY] = count;
+		}
 		else
-			return 1;
+		{
+			counts[NEURON_TYPE_EXCITATORY] = GetGroupGene(GENE_NUM_EXCITATORY_NEURONS, group).AsInt(
+				Simulation::PARAMS.minENeuronsPerGroup,
+				Simulation::PARAMS.maxENeuronsPerGroup);
+			counts[NEURON_TYPE_INHIBITORY] = GetGroupGene(GENE_NUM_INHIBITORY_NEURONS, group).AsInt(
+				Simulation::PARAMS.minINeuronsPerGroup,
+				Simulation::PARAMS.maxINeuronsPerGroup);
+		}
 	}
 
-	if (neuronType == NEURON_TYPE_EXCITATORY)
-	{
-		return GetGroupGene(GENE_NUM_EXCITATORY_NEURONS, group).AsInt(
-			Simulation::PARAMS.minENeuronsPerGroup,
-			Simulation::PARAMS.maxENeuronsPerGroup);
-	}
-	else
+	// Synapse counts and infos (the counts depend on the neuron counts).
+	for (int groupFrom = 0; groupFrom < s_numGroups; groupFrom++)
 	{
-		return GetGroupGene(GENE_NUM_INHIBITORY_NEURONS, group).AsInt(
-			Simulation::PARAMS.minINeuronsPerGroup,
-			Simulation::PARAMS.maxINeuronsPerGroup);
+		for (int groupTo = 0; groupTo < s_numGroups; groupTo++)
+		{
+			int index = ((groupFrom * s_numGroups) + groupTo) * NUM_SYNAPSE_TYPES;
+			for (int type = 0; type < NUM_SYNAPSE_TYPES; type++)
+			{
+				m_synapseInfos[index + type] = DecodeSynapseInfo(groupFrom, groupTo, (SynapseType) type);
+				m_synapseCounts[index + type] = DecodeSynapseCount(groupFrom, groupTo, (SynapseType) type);
+			}
+		}
 	}
-}
 
+	m_isDecoded = true;
+}
 
-int BrainGenome::GetSynapseCount(int groupFrom, int groupTo)
+void BrainGenome::OnDataChanged()
 {
-	int count = 0;
-	for (int i = 0; i < NUM_SYNAPSE_TYPES; i++)
-		count += GetSynapseCount(groupFrom, groupTo, (SynapseType) i);
-	return count;
+	m_isDecoded = false;
 }
 
+BrainGenome::NeurGroupSynapseInfo BrainGenome::DecodeSynapseInfo(int groupFrom, int groupTo, SynapseType synapseType)
+{
+	NeurGroupSynapseInfo synapseInfo;
+	synapseInfo.connectionDensity = GetSynapseGene(
+		GENE_CONNECTION_DENSITY, groupFrom, groupTo, synapseType).AsFloat(
+		Simulation::PARAMS.minConnectionDensity,
+		Simulation::PARAMS.maxConnectionDensity);
+	synapseInfo.topologicalDistortion = GetSynapseGene(
+		GENE_TOPOLOGICAL_DISTORTION, groupFrom, groupTo, synapseType).AsFloat(
+		Simulation::PARAMS.minTopologicalDistortion,
+		Simulation::PARAMS.maxTopologicalDistortion);
+	synapseInfo.synapseLearningRate = GetSynapseGene(
+		GENE_SYNAPSE_LEARNING_RATE, groupFrom, groupTo, synapseType).AsFloat(
+		Simulation::PARAMS.minSynapseLearningRate,
+		Simulation::PARAMS.maxSynapseLearningRate);
+
+	// Negate learning rate for inhibitory neurons.
+	if (GetSynapseNeuronType_From(synapseType) == NEURON_TYPE_INHIBITORY)
+	{
+		synapseInfo.synapseLearningRate = Math::Min(-1.e-10f, -synapseInfo.synapseLearningRate);
+	}
+
+	return synapseInfo;
+}
 
-int BrainGenome::GetSynapseCount(int groupFrom, int groupTo, SynapseType synapseType)
+// Note: the neuron counts must already be decoded.
+int BrainGenome::DecodeSynapseCount(int groupFrom, int groupTo, SynapseType synapseType)
 {
 	float connectionDensity = GetSynapseGene(GENE_CONNECTION_DENSITY, groupFrom, groupTo, synapseType)
 		.AsFloat(Simulation::PARAMS.minConnectionDensity, Simulation::PARAMS.maxConnectionDensity);
@@ -241,8 +309,8 @@ int BrainGenome::GetSynapseCount(int groupFrom, int groupTo, SynapseType synapse
 		return 0;
 	}
 	
-	int nFrom = GetNeuronCount(neuronType_from, groupFrom);
-	int nTo   = GetNeuronCount(neuronType_to, groupTo);
+	int nFrom = m_neuronCounts[(groupFrom * 2) + neuronType_from];
+	int nTo   = m_neuronCounts[(groupTo * 2) + neuronType_to];
 	
 	if (groupFrom == groupTo)
 	{
@@ -273,7 +341,7 @@ int BrainGenome::GetNumCrossoverPoints()
 		Simulation::PARAMS.maxNumCrossoverPoints);
 }
 
-void BrainGenome::GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints)
+void BrainGenome::GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints, RandomNumberGenerator& rng)
 {
 	int genomeSize = GetDataSize();
 
@@ -281,56 +349,25 @@ void BrainGenome::GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoint
 
 	// Guarantee one crossover point in the physiological genes
 	// and another in the neurological genes.
-	crossoverPoints[0] = Random::NextInt(0, NUM_PHYSIOLOGICAL_GENES);
-	crossoverPoints[1] = Random::NextInt(NUM_PHYSIOLOGICAL_GENES, genomeSize);
+	crossoverPoints[0] = rng.NextInt(0, NUM_PHYSIOLOGICAL_GENES);
+	crossoverPoints[1] = rng.NextInt(NUM_PHYSIOLOGICAL_GENES, genomeSize);
 
-	// Pick random points for the rest.
-	for (int i = 2; i < numCrossoverPoints; i++)
+	// Pick random points for the rest. Sort all the points and remove any
+	// duplicates, then pick new points to replace them until all are unique.
+	int numUnique = 2;
+	while (numUnique < numCrossoverPoints)
 	{
-		int cp;
-		bool isUnique = true;
-
-		// Pick a unique crossover point.
-		do
-		{
-			cp = Random::NextInt(0, genomeSize);
-			isUnique = true;
-			for (int j = 0; j < i; j++)
-			{
-				if (crossoverPoints[j] == cp)
-				{
-					isUnique = false;
-					break;
-				}
-			}
-		}
-		while (!isUnique);
-
-		// Insert the crossover point in sorted order.
-
-		// Find the index at which to insert the new crossover point.
-		int insertIndex = i;
-		for (int j = 0; j < i; j++)
-		{
-			if (cp < crossoverPoints[j])
-			{
-				insertIndex = j;
-				break;
-			}
-		}
-
-		// Shift larger crossover points up.
-		for (int j = i; j > insertIndex; j--)
-			crossoverPoints[j] = crossoverPoints[j - 1];
+		for (int i = numUnique; i < numCrossoverPoints; i++)
+			crossoverPoints[i] = rng.NextInt(0, genomeSize);
 
-		// Finally, insert the crossover point in its rightful place.
-		crossoverPoints[insertIndex] = cp;
+		std::sort(crossoverPoints, crossoverPoints + numCrossoverPoints);
+		numUnique = (int) (std::unique(crossoverPoints, crossoverPoints + numCrossoverPoints) - crossoverPoints);
 	}
 }
 
-void BrainGenome::Mutate()
+void BrainGenome::Mutate(RandomNumberGenerator& rng)
 {
-	Genome::Mutate(GetMutationRate());
+	Genome::Mutate(GetMutationRate(), rng);
 }
 
 
@@ -3,6 +3,7 @@
 
 #include "Genome.h"
 #include <ArtificialLife/brain/NeuronType.h>
+#include <vector>
 
 
 class BrainGenome : public Genome
@@ -76,6 +77,10 @@ public:
 	BrainGenome();
 	~BrainGenome();
 
+	// Compute the gene layout from the simulation parameters. This must be
+	// called whenever the parameters change, before creating any genomes.
+	static void InitializeLayout();
+
 	//-----------------------------------------------------------------------------
 	// Gene access.
 
@@ -113,10 +118,30 @@ public:
 	// Overridden methods.
 	
 	int GetNumCrossoverPoints() override;
-	void GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints) override;
-	void Mutate() override;
+	void GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints, RandomNumberGenerator& rng) override;
+	void Mutate(RandomNumberGenerator& rng) override;
+
+protected:
+	void OnDataChanged() override;
 
 private:
+	void DecodeNeurogenetics();
+	NeurGroupSynapseInfo DecodeSynapseInfo(int groupFrom, int groupTo, SynapseType synapseType);
+	int DecodeSynapseCount(int groupFrom, int groupTo, SynapseType synapseType);
+
+	// Gene layout, shared by all genomes.
+	static int s_numGroups;
+	static int s_groupGenesBegin;
+	static int s_synapseGenesBegin;
+	static int s_genomeSize;
+
+	// Neuron counts, synapse counts and synapse infos decoded from the genes,
+	// indexed by [group][neuron type] and [groupFrom][groupTo][synapse type].
+	// These are decoded on first access after the genome changes.
+	bool								m_isDecoded;
+	std::vector<int>					m_neuronCounts;
+	std::vector<int>					m_synapseCounts;
+	std::vector<NeurGroupSynapseInfo>	m_synapseInfos;
 };
 
 
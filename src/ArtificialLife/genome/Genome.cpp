@@ -1,6 +1,6 @@
 #include "Genome.h"
 #include <assert.h>
-#include <AppLib/util/Random.h>
+#include <string.h>
 
 
 Genome::Genome()
@@ -14,11 +14,21 @@ Genome::~Genome()
 void Genome::InitSize(int size)
 {
 	m_data.resize(size);
+	OnDataChanged();
 }
 
 void Genome::CopyFrom(Genome* genome)
 {
 	m_data = genome->m_data;
+	OnDataChanged();
+}
+
+// Exchange the data of two genomes, without copying it.
+void Genome::Swap(Genome& other)
+{
+	m_data.swap(other.m_data);
+	OnDataChanged();
+	other.OnDataChanged();
 }
 
 unsigned char Genome::GetGeneValue(int index) const
@@ -36,47 +46,63 @@ float Genome::GetGeneValue(int index, float rangeMin, float rangeMax) const
 	return (rangeMin + (((float) m_data[index] / 255.0f) * (rangeMax - rangeMin)));
 }
 
-void Genome::Randomize()
+void Genome::Randomize(RandomNumberGenerator& rng)
 {
 	// Randomize each bit.
     for (unsigned int byte = 0; byte < m_data.size(); byte++)
     {
         for (int bit = 0; bit < 8; bit++)
         {
-            if (Random::NextBool())
+            if (rng.NextBool())
                 m_data[byte] |= char(1 << (7 - bit));
             else
                 m_data[byte] &= char(255 ^ (1 << (7 - bit)));
 		}
 	}
+
+	OnDataChanged();
 }
 
-void Genome::Mutate(float mutationRate)
+void Genome::Mutate(float mutationRate, RandomNumberGenerator& rng)
 {
 	// Randomly flip bits.
     for (unsigned int byte = 0; byte < m_data.size(); byte++)
     {
         for (int bit = 0; bit < 8; bit++)
         {
-			if (Random::NextFloat() < mutationRate)
+			if (rng.NextFloat() < mutationRate)
                 m_data[byte] ^= char(1 << (7 - bit));
 		}
 	}
+
+	OnDataChanged();
 }
 
-void Genome::Crossover(Genome* g1, Genome* g2)
+void Genome::Crossover(Genome* g1, Genome* g2, RandomNumberGenerator& rng)
 {
 	assert(g1->GetDataSize() == g2->GetDataSize());
 
 	int genomeSize = g1->GetDataSize();
+	m_data.resize(genomeSize);
+
+	// Crossing over identical parents just gives a copy of them.
+	if (g1 == g2 || memcmp(&g1->m_data[0], &g2->m_data[0], genomeSize) == 0)
+	{
+		if (g1 != this)
+			memcpy(&m_data[0], &g1->m_data[0], genomeSize);
+		OnDataChanged();
+		return;
+	}
 
 	// Get a list of the crossover points.
-	int numCrossoverPoints = (Random::NextBool() ? g1->GetNumCrossoverPoints() : g2->GetNumCrossoverPoints());
-	int* crossoverPoints = new int[numCrossoverPoints];
-	GetCrossoverPoints(crossoverPoints, numCrossoverPoints);
+	int numCrossoverPoints = (rng.NextBool() ? g1->GetNumCrossoverPoints() : g2->GetNumCrossoverPoints());
+	if (numCrossoverPoints > MAX_CROSSOVER_POINTS)
+		numCrossoverPoints = MAX_CROSSOVER_POINTS;
+	int crossoverPoints[MAX_CROSSOVER_POINTS];
+	GetCrossoverPoints(crossoverPoints, numCrossoverPoints, rng);
 	
 	Genome* parents[] = { g1, g2 };
-	int parentIndex = (Random::NextBool() ? 0 : 1);
+	int parentIndex = (rng.NextBool() ? 0 : 1);
 
 	// Crossover the genes.
 	for (int i = 0; i < numCrossoverPoints + 1; i++)
@@ -89,14 +115,17 @@ void Genome::Crossover(Genome* g1, Genome* g2)
 			endIndex = crossoverPoints[i];
 
 		// Copy the genome data.
-		memcpy_s(&m_data[0] + startIndex, genomeSize - startIndex,
-			     &parents[parentIndex]->m_data[0] + startIndex, endIndex - startIndex);
+		if (parents[parentIndex] != this && endIndex > startIndex)
+		{
+			memcpy(&m_data[0] + startIndex,
+				   &parents[parentIndex]->m_data[0] + startIndex, endIndex - startIndex);
+		}
 
 		// Switch parents for the next strip.
 		parentIndex = 1 - parentIndex;
 	}
-	
-	delete [] crossoverPoints;
+
+	OnDataChanged();
 
 	/*
 	// TODO: Variable number of crossover points (one gaurenteed in phsiological), get rid of crossover rate.
@@ -1,6 +1,7 @@
 #ifndef _GENOME_H_
 #define _GENOME_H_
 
+#include <AppLib/util/Random.h>
 #include <vector>
 
 
@@ -34,6 +35,11 @@ private:
 
 class Genome
 {
+public:
+	// Crossover point arrays are kept on the stack, so the number of points
+	// is limited.
+	static const int MAX_CROSSOVER_POINTS = 64;
+
 public:
 	Genome();
 	virtual ~Genome();
@@ -41,6 +47,7 @@ public:
 	void InitSize(int size);
 
 	void CopyFrom(Genome* genome);
+	void Swap(Genome& other);
 
 	Gene GetGene(int offset) { return Gene(offset, &m_data[offset]); }
 
@@ -51,14 +58,22 @@ public:
 	unsigned char* GetData() { return &m_data[0]; }
 	int GetDataSize() { return (int) m_data.size(); }
 	
-	virtual void Mutate() {}
+	// The random number generator is passed in so that genomes can be
+	// created on multiple threads at once.
+	virtual void Mutate(RandomNumberGenerator& rng) {}
 
+	// Crossover points must be unique and in ascending order.
 	virtual int GetNumCrossoverPoints() { return 1; }
-	virtual void GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints) { }
+	virtual void GetCrossoverPoints(int* crossoverPoints, int numCrossoverPoints, RandomNumberGenerator& rng) { }
+
+	void Randomize(RandomNumberGenerator& rng);
+	void Mutate(float mutationRate, RandomNumberGenerator& rng);
+	void Crossover(Genome* g1, Genome* g2, RandomNumberGenerator& rng);
 
-	void Randomize();
-	void Mutate(float mutationRate);
-	void Crossover(Genome* g1, Genome* g2);
+protected:
+	// Called whenever the genome's data is modified, so that derived
+	// genomes can discard anything they have decoded from it.
+	virtual void OnDataChanged() {}
 
 private:
 	std::vector<unsigned char> m_data;
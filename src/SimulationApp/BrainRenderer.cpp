@@ -1,6 +1,5 @@
 #include "BrainRenderer.h"
 #include <AppLib/math/MathLib.h>
-#include <ArtificialLife/Simulation.h>
 
 
 BrainRenderer::BrainRenderer()
@@ -8,18 +7,15 @@ BrainRenderer::BrainRenderer()
 }
 
 
-void BrainRenderer::RenderBrain(Graphics* g, Agent* agent, const Vector2f& position)
+void BrainRenderer::RenderBrain(Graphics* g, const SelectedAgentSnapshot& agent, const Vector2f& position)
 {
-	NeuronModel* neuralNet = agent->GetBrain()->GetNeuralNet();
-	NeuronModel::Dimensions dims = neuralNet->GetDimensions();
+	const NeuronModel::Dimensions& dims = agent.brainDimensions;
 		
 	int numNonInputNeurons	= dims.GetNumNonInputNeurons();
-	int numRedNeurons		= agent->GetGenome()->GetNumRedNeurons();
-	int numGreenNeurons		= agent->GetGenome()->GetNumGreenNeurons();
-	int numBlueNeurons		= agent->GetGenome()->GetNumBlueNeurons();
+	int numRedNeurons		= agent.numRedNeurons;
+	int numGreenNeurons		= agent.numGreenNeurons;
+	int numBlueNeurons		= agent.numBlueNeurons;
 	int numVisionNeurons	= numRedNeurons + numGreenNeurons + numBlueNeurons;
-	int numInputGroups		= Simulation::PARAMS.numInputNeurGroups;
-	int numOutputGroups		= Simulation::PARAMS.numInputNeurGroups;
 
 	Vector2f cellSize(10, 10);
 	Vector2f boxSize(dims.numNeurons * cellSize.x,
@@ -41,19 +37,18 @@ void BrainRenderer::RenderBrain(Graphics* g, Agent* agent, const Vector2f& posit
 	// Draw synapses and neuron activations.
 	for (int i = 0; i < dims.numNeurons; i++)
 	{
-		auto neuron = neuralNet->GetNeuron(i);
+		const Neuron& neuron = agent.neurons[i];
 		
 		// Draw all the synapses going to this neuron (a single row in the connection matrix).
 		for (int isyn = neuron.startSynapse; isyn < neuron.endSynapse; isyn++)
 		{
-			auto synapse = neuralNet->GetSynapse(isyn);
-			auto fromNeuron = neuralNet->GetNeuron(synapse.fromNeuron);
+			const Synapse& synapse = agent.synapses[isyn];
 				
 			// Check if is an inhibitory and an excitatory connection to this neuron.
 			int count = 0;
 			for (int jsyn = neuron.startSynapse; jsyn < neuron.endSynapse; jsyn++)
 			{
-				if (neuralNet->GetSynapse(jsyn).fromNeuron == synapse.fromNeuron)
+				if (agent.synapses[jsyn].fromNeuron == synapse.fromNeuron)
 					count++;
 			}
 
@@ -88,35 +83,35 @@ void BrainRenderer::RenderBrain(Graphics* g, Agent* agent, const Vector2f& posit
 				{
 					if (k == 0)
 					{
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
 
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
 					}
 					else
 					{
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
 					}
 				}
 				else
 				{
 					if (excitatory)
 					{
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
 					}
 					else
 					{
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (synapse.toNeuron + 1 - dims.numInputNeurons) * cellSize.y);
-						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (synapse.toNeuron + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 1) * cellSize.x, (i + 1 - dims.numInputNeurons) * cellSize.y);
+						glVertex2f((synapse.fromNeuron + 0) * cellSize.x, (i + 0 - dims.numInputNeurons) * cellSize.y);
 					}
 				}
 
@@ -124,8 +119,8 @@ void BrainRenderer::RenderBrain(Graphics* g, Agent* agent, const Vector2f& posit
 			}
 		}
 
-		float activationCurr = neuralNet->GetNeuronActivation(i);
-		float activationPrev = neuralNet->GetNeuronActivationPrev(i);
+		float activationCurr = agent.activations[i];
+		float activationPrev = agent.prevActivations[i];
 		
 		// Draw the activation value for the current step (to the right).
 		glBegin(GL_QUADS);
@@ -164,12 +159,9 @@ void BrainRenderer::RenderBrain(Graphics* g, Agent* agent, const Vector2f& posit
 	std::vector<int> groupSeps;
 	groupSeps.push_back(dims.numInputNeurons);
 	groupSeps.push_back(dims.numInputNeurons + dims.numOutputNeurons);
-	for (int i = numInputGroups + numOutputGroups; i < agent->GetBrain()->GetNumNeuralGroups(); i++)
+	for (unsigned int i = 0; i < agent.internalGroupSizes.size(); i++)
 	{
-		int numNeuronsInGroup = 
-			agent->GetGenome()->GetNeuronCount(NEURON_TYPE_EXCITATORY, i) +
-			agent->GetGenome()->GetNeuronCount(NEURON_TYPE_INHIBITORY, i);
-		sepCounter += numNeuronsInGroup;
+		sepCounter += agent.internalGroupSizes[i];
 		groupSeps.push_back(sepCounter);
 	}
 
@@ -2,7 +2,7 @@
 #define _BRAIN_RENDERER_H_
 
 #include <AppLib/graphics/Graphics.h>
-#include <ArtificialLife/agent/Agent.h>
+#include <ArtificialLife/RenderSnapshot.h>
 
 
 class BrainRenderer
@@ -10,7 +10,7 @@ class BrainRenderer
 public:
 	BrainRenderer();
 	
-	void RenderBrain(Graphics* g, Agent* agent, const Vector2f& position);
+	void RenderBrain(Graphics* g, const SelectedAgentSnapshot& agent, const Vector2f& position);
 
 private:
 
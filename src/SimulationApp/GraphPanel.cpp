@@ -23,13 +23,13 @@ Graph::Graph(std::string name, const Color& color)
 
 void Graph::AddData(float data)
 {
-	m_data.push_back(data);
+	m_series.Add(data);
 	m_bounds.mins.x = 0.0f;
-	m_bounds.maxs.x = (float) m_data.size() - 1;
+	m_bounds.maxs.x = (float) m_series.GetCount() - 1;
 
-	if (data < m_bounds.mins.y || m_data.size() == 1)
+	if (data < m_bounds.mins.y || m_series.GetCount() == 1)
 		m_bounds.mins.y = data;
-	if (data > m_bounds.maxs.y || m_data.size() == 1)
+	if (data > m_bounds.maxs.y || m_series.GetCount() == 1)
 		m_bounds.maxs.y = data;
 }
 
@@ -250,13 +250,40 @@ void GraphPanel::GetGraphRange(const GraphInfo& graph, float& rangeMin, float& r
 
 void GraphPanel::DrawGraph(Graphics* g, Graph* graph)
 {
-	glBegin(GL_LINE_STRIP);
-	glColor4ubv(graph->GetColor().data());
+	// Draw about one bucket per pixel, so the cost doesn't grow with the
+	// length of the history.
+	const TimeSeries& series = graph->GetSeries();
+	int level = series.PickLevel(Math::Max(1, m_graphViewport.width));
+	int numBuckets = series.GetBucketCount(level);
+
+	// Draw the range of each bucket that has more than one sample.
+	Color color = graph->GetColor();
+	Color rangeColor(color.r / 2, color.g / 2, color.b / 2, color.a);
+	glBegin(GL_LINES);
+	glColor4ubv(rangeColor.data());
+	for (int i = 0; i < numBuckets; i++)
+	{
+		const TimeSeriesBucket& bucket = series.GetBucket(level, i);
+		float x = series.GetBucketStart(level, i) + ((bucket.count - 1) * 0.5f);
 
-	for (int i = 0; i < graph->GetDataCount(); i++)
+		if (bucket.count > 1 && x >= m_bounds.mins.x && x <= m_bounds.maxs.x)
+		{
+			Vector2f bottom = GetPointOnGraph(Vector2f(x, bucket.min));
+			Vector2f top = GetPointOnGraph(Vector2f(x, bucket.max));
+			glVertex2fv(bottom.data());
+			glVertex2fv(top.data());
+		}
+	}
+	glEnd();
+
+	// Draw a line through the mean of each bucket.
+	glBegin(GL_LINE_STRIP);
+	glColor4ubv(color.data());
+	for (int i = 0; i < numBuckets; i++)
 	{
-		float x = (float) i;
-		float y = graph->GetData(i);
+		const TimeSeriesBucket& bucket = series.GetBucket(level, i);
+		float x = series.GetBucketStart(level, i) + ((bucket.count - 1) * 0.5f);
+		float y = bucket.GetMean();
 
 		if (x >= m_bounds.mins.x && x <= m_bounds.maxs.x)
 		{
@@ -264,6 +291,5 @@ void GraphPanel::DrawGraph(Graphics* g, Graph* graph)
 			glVertex2fv(point.data());
 		}
 	}
-	
 	glEnd();
 }
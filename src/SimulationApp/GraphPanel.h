@@ -2,6 +2,7 @@
 #define _GRAPH_PANEL_H_
 
 #include <AppLib/graphics/Graphics.h>
+#include "TimeSeries.h"
 #include <vector>
 #include <string>
 
@@ -36,15 +37,15 @@ public:
 	const Color&		GetColor()	const { return m_color; }
 	const Bounds&		GetBounds()	const { return m_bounds; }
 
-	int		GetDataCount()		const { return (int) m_data.size(); }
-	float	GetData(int index)	const { return m_data[index]; }
+	int					GetDataCount()	const { return m_series.GetCount(); }
+	const TimeSeries&	GetSeries()		const { return m_series; }
 	
 	void AddData(float data);
 
 private:
 	Color				m_color;
 	std::string			m_name;
-	std::vector<float>	m_data;
+	TimeSeries			m_series;
 	Bounds				m_bounds;
 };
 
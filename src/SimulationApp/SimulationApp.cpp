@@ -8,14 +8,18 @@
 
 const char* g_fontPath = "../../assets/font_console.png";
 const char* g_replayPath = "../../replays/replay.alrp";
+const char* g_metricsPath = "../../replays/metrics";
 
 
 
 SimulationApp::SimulationApp()
 	: m_font(NULL)
 	, m_simulation(NULL)
+	, m_simulationThread(NULL)
 	, m_replayRecorder(NULL)
+	, m_metricsRecorder(NULL)
 	, m_brainRenderer(NULL)
+	, m_batchTicks(0)
 {
 }
 
@@ -23,7 +27,9 @@ SimulationApp::~SimulationApp()
 {
 	for (unsigned int i = 0; i < m_graphList.size(); i++)
 		delete m_graphList[i];
+	delete m_simulationThread; m_simulationThread = NULL;
 	delete m_replayRecorder; m_replayRecorder = NULL;
+	delete m_metricsRecorder; m_metricsRecorder = NULL;
 	delete m_brainRenderer; m_brainRenderer = NULL;
 	delete m_simulation; m_simulation = NULL;
 	delete m_font; m_font = NULL;
@@ -66,6 +72,7 @@ void SimulationApp::OnInitialize()
 		
 	m_simulation		= new Simulation();
 	m_replayRecorder	= new ReplayRecorder(m_simulation);
+	m_metricsRecorder	= new MetricsRecorder(m_simulation);
 	m_brainRenderer		= new BrainRenderer();
 
 	//-----------------------------------------------------------------------------
@@ -78,7 +85,6 @@ void SimulationApp::OnInitialize()
 	m_showGraphs			= false;
 	m_showBrain				= false;
 	m_followAgent			= false;
-	m_selectedAgent			= NULL;
 	m_selectedAgentID		= 0;
 
 	m_cameraFOV				= 80.0f * Math::DEG_TO_RAD;
@@ -100,6 +106,17 @@ void SimulationApp::OnInitialize()
 	params.minFood					= 120;//220;
 	params.maxFood					= 120;//300;
 	params.initialFoodCount			= 120;//220;
+	params.numFoodSites				= 480;
+	params.numFoodPatches			= 0;
+	params.foodPatchRadius			= 150.0f;
+	params.statisticsInterval		= 20;
+	params.spatialSortInterval		= 50;
+	params.visionUpdateInterval		= 1;
+	params.brainUpdateInterval		= 1;
+	params.targetTicksPerSecond		= 0.0f;
+	params.populationControlInterval	= 200;
+	params.populationControlHysteresis	= 0.15f;
+	params.numWorkerThreads			= 0;
 		
 	//-----------------------------------------------------------------------------
 	// Energy and fitness parameters.
@@ -134,7 +151,13 @@ void SimulationApp::OnInitialize()
 	params.mateWait					= 120;
 	params.initialMateWait			= 120;
 	params.retinaResolution			= 16;
+	params.retinaOversampling		= 2;
 	params.retinaVerticalFOV		= 0.01f;
+	params.visionCacheMode			= VisionCacheMode::VISION_CACHE_EXACT;
+	params.visionCacheCellSize		= 100.0f;
+	params.visionCacheMoveThreshold	= 0.5f;
+	params.visionCacheTurnThreshold	= 0.01f;
+	params.visionCacheColorThreshold= 0.05f;
 
 	//-----------------------------------------------------------------------------
 	// Agent gene ranges.
@@ -182,8 +205,11 @@ void SimulationApp::OnInitialize()
 	params.minBiasLearningRate		= 0.0f; // unused
 	params.maxBiasLearningRate		= 0.1f; // unused
 	params.logisticSlope			= 1.0f;
+	params.activationFunction		= ACTIVATION_FUNCTION_SIMD;
+	params.maxActivationError		= 0.0001f;
 	params.maxWeight				= 1.0f;
 	params.initMaxWeight			= 0.5f;
+	params.compactSynapses			= false;
 	params.decayRate				= 0.99f;
 	
 	//-----------------------------------------------------------------------------
@@ -231,6 +257,21 @@ void SimulationApp::OnInitialize()
 
 	// Initialize the simulation.
 	m_simulation->Initialize(params);
+	m_simulationThread = new SimulationThread(m_simulation);
+	m_simulationThread->Start(m_selectedAgentID);
+
+	if (IsBatchRun())
+	{
+		m_batchStartTime		= Time::GetTime();
+		m_batchReportTime	= m_batchStartTime;
+		m_batchReportAge		= 0;
+		if (m_metricsRecorder->BeginRecording(g_metricsPath))
+			std::cout << "Recording metrics to " << g_metricsPath << std::endl;
+		std::cout << "Running " << m_batchTicks << " ticks in a hidden window" << std::endl;
+		std::cout << "Update intervals: vision " << params.visionUpdateInterval
+			<< ", brain " << params.brainUpdateInterval
+			<< ", statistics " << params.statisticsInterval << " ticks" << std::endl;
+	}
 	
 	UpdateScreenLayout();
 	ResetCamera();
@@ -257,23 +298,40 @@ void SimulationApp::ResetCamera()
 
 void SimulationApp::OnUpdate(float timeDelta)
 {
-	// Update the simulation.
-	m_simulation->Update();
-	
+	if (!IsBatchRun())
+	{
+		UpdateControls(timeDelta);
+		UpdateScreenLayout();
+	}
+
+	// The simulation ticks on its own thread. Until its tick is done, keep
+	// drawing the snapshot from the last tick. The next tick's vision is
+	// rendered as soon as the tick has moved the agents.
+	Graphics g(GetWindow());
+	m_simulationThread->SubmitVision(&g);
+	if (!m_simulationThread->FinishTick())
+		return;
+
 	// Check if our selected agent has died.
 	// TODO: make an event queue for simultaion (for births and deaths)
-	if (m_selectedAgent != NULL && m_simulation->GetAgent(m_selectedAgentID) == NULL)
-	{
-		m_selectedAgent = NULL;
+	if (m_selectedAgentID != 0 && m_simulation->GetAgent(m_selectedAgentID) == NULL)
 		m_selectedAgentID = 0;
-	}
 
-	UpdateControls(timeDelta);
-	UpdateScreenLayout();
 	UpdateStatistics();
 	
 	if (m_replayRecorder->IsRecording())
 		m_replayRecorder->RecordStep();
+	if (m_metricsRecorder->IsRecording() && m_simulation->WereStatisticsSampled())
+		m_metricsRecorder->RecordSample();
+
+	if (IsBatchRun())
+	{
+		UpdateBatchRun();
+		if (m_simulation->GetWorldAge() >= m_batchTicks)
+			return;
+	}
+
+	m_simulationThread->BeginTick(&g, m_selectedAgentID);
 }
 
 void SimulationApp::UpdateControls(float timeDelta)
@@ -305,6 +363,20 @@ void SimulationApp::UpdateControls(float timeDelta)
 			std::cout << " ****** RECORDING STARTED ******" << std::endl;
 		}
 	}
+
+	// F6: Start/stop recording metrics.
+	if (keyboard->IsKeyPressed(Keys::F6))
+	{
+		if (m_metricsRecorder->IsRecording())
+		{
+			m_metricsRecorder->StopRecording();
+			std::cout << " ****** METRICS RECORDING STOPPED ******" << std::endl;
+		}
+		else if (m_metricsRecorder->BeginRecording(g_metricsPath))
+		{
+			std::cout << " ****** METRICS RECORDING STARTED ******" << std::endl;
+		}
+	}
 	
 	// G: Show/hide graphs.
 	if (keyboard->IsKeyPressed(Keys::G))
@@ -397,10 +469,13 @@ void SimulationApp::UpdateControls(float timeDelta)
 	if (keyboard->IsKeyPressed(Keys::HOME))
 		ResetCamera();
 	
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
+
 	// Update agent camera following.
-	if (m_followAgent && m_selectedAgent != NULL)
+	const AgentSnapshot* selectedAgent = snapshot.GetAgent(m_selectedAgentID);
+	if (m_followAgent && selectedAgent != NULL)
 	{
-		m_camera.position.SetXY(m_selectedAgent->GetPosition());
+		m_camera.position.SetXY(selectedAgent->position);
 	}
 	
 	//-----------------------------------------------------------------------------
@@ -440,16 +515,15 @@ void SimulationApp::UpdateControls(float timeDelta)
 
 	if (mouse->IsButtonPressed(MouseButtons::LEFT) && m_panelWorld.Contains(mouse->GetX(), mouse->GetY()))
 	{
-		m_selectedAgent = NULL;
 		m_selectedAgentID = 0;
 		float nearestAgentDist = 0.0f;
-		Agent* nearestAgent = NULL;
+		const AgentSnapshot* nearestAgent = NULL;
 
 		// Find the agent closest to the mouse cursor.
-		for (auto it = m_simulation->agents_begin(); it != m_simulation->agents_end(); ++it)
+		for (unsigned int i = 0; i < snapshot.agents.size(); i++)
 		{
-			Agent* agent = *it;
-			float dist = Vector2f::Dist(m_cursorPos, agent->GetPosition());
+			const AgentSnapshot* agent = &snapshot.agents[i];
+			float dist = Vector2f::Dist(m_cursorPos, agent->position);
 			if (dist < nearestAgentDist || nearestAgent == NULL)
 			{
 				nearestAgent = agent;
@@ -457,11 +531,8 @@ void SimulationApp::UpdateControls(float timeDelta)
 			}
 		}
 
-		if (nearestAgent != NULL && nearestAgentDist < m_agentSelectionRadius * nearestAgent->GetSize())
-		{
-			m_selectedAgent = nearestAgent;
-			m_selectedAgentID = nearestAgent->GetID();
-		}
+		if (nearestAgent != NULL && nearestAgentDist < m_agentSelectionRadius * nearestAgent->size)
+			m_selectedAgentID = nearestAgent->id;
 	}
 }
 
@@ -562,12 +633,14 @@ void SimulationApp::UpdateScreenLayout()
 
 void SimulationApp::UpdateStatistics()
 {
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
+
 	// Update world statistics.
-	if (m_simulation->GetWorldAge() % 20 == 0)
+	if (snapshot.statisticsSampled)
 	{
-		SimulationStats simStats = m_simulation->GetStatistics();
+		const SimulationStats& simStats = snapshot.stats;
 		
-		m_graphPopulation->GetGraph()->AddData((float) m_simulation->GetNumAgents());
+		m_graphPopulation->GetGraph()->AddData((float) snapshot.numAgents);
 		m_graphEnergy->GetGraph()->AddData(simStats.totalEnergy);
 		m_graphEnergyUsage->GetGraph()->AddData(simStats.avgEnergyUsage);
 		m_graphVisionNeurons->GetGraph("red")->AddData(simStats.avgNumRedNeurons);
@@ -588,26 +661,49 @@ void SimulationApp::UpdateStatistics()
 		m_graphBehavior->GetGraph("eat")->AddData(simStats.avgEatAmount);
 		m_graphBehavior->GetGraph("mate")->AddData(simStats.avgMateAmount);
 		m_graphBehavior->GetGraph("fight")->AddData(simStats.avgFightAmount);
+		m_graphFitness->GetGraph("worst")->AddData(simStats.worstFitness);
+		m_graphFitness->GetGraph("best")->AddData(simStats.bestFitness);
+		m_graphFitness->GetGraph("average")->AddData(simStats.avgFitness);
+
+		// Measure how busy the job system's workers have been since the last
+		// sample.
+		JobSystem* jobSystem = m_simulation->GetJobSystem();
+		m_workerUtilization.resize(jobSystem->GetNumWorkers());
+		for (int i = 0; i < jobSystem->GetNumWorkers(); i++)
+			m_workerUtilization[i] = jobSystem->GetWorkerUtilization(i);
+		jobSystem->ResetUtilization();
+	}
+}
 
-		float totalfit = 0.0f;
-		float avgFit   = 0.0f;
-		float worstFit = 0.0f;
-		float bestFit  = 0.0f;
-		if (m_recentFitnesses.size() > 0)
-		{
-			for (unsigned int i = 0; i < m_recentFitnesses.size(); i++)
-			{
-				totalfit += m_recentFitnesses[i];
-				if (m_recentFitnesses[i] < worstFit || i == 0)
-					worstFit = m_recentFitnesses[i];
-				if (m_recentFitnesses[i] > bestFit || i == 0)
-					bestFit = m_recentFitnesses[i];
-			}
-			avgFit = totalfit / (float) m_recentFitnesses.size();
-		}
-		m_graphFitness->GetGraph("worst")->AddData(worstFit);
-		m_graphFitness->GetGraph("best")->AddData(bestFit);
-		m_graphFitness->GetGraph("average")->AddData(avgFit);
+
+// Report the simulation's throughput, and quit when all the ticks are done.
+void SimulationApp::UpdateBatchRun()
+{
+	int worldAge = m_simulation->GetWorldAge();
+	double time = Time::GetTime();
+
+	if (worldAge - m_batchReportAge >= 1000 || worldAge >= m_batchTicks)
+	{
+		double ticksPerSecond = (worldAge - m_batchReportAge) /
+			Math::Max(time - m_batchReportTime, 0.000001);
+		VisionCache& visionCache = m_simulation->GetVisionCache();
+		double visionTime = m_simulationThread->GetStageTime(PIPELINE_STAGE_VISION_SUBMIT) +
+			m_simulationThread->GetStageTime(PIPELINE_STAGE_VISION_WAIT);
+		std::cout << "tick " << worldAge << "/" << m_batchTicks
+			<< ": " << ticksPerSecond << " ticks/s"
+			<< ", population " << m_simulation->GetNumAgents()
+			<< ", vision " << (visionTime * 1000.0) << " ms/tick"
+			<< ", vision cache " << (int) (visionCache.GetHitRate() * 100.0f + 0.5f) << "% hits"
+			<< std::endl;
+		visionCache.ResetCounters();
+		m_batchReportAge = worldAge;
+		m_batchReportTime = time;
+	}
+
+	if (worldAge >= m_batchTicks)
+	{
+		std::cout << "Ran " << worldAge << " ticks in " << (time - m_batchStartTime) << " s" << std::endl;
+		Quit();
 	}
 }
 
@@ -618,9 +714,12 @@ void SimulationApp::UpdateStatistics()
 
 void SimulationApp::OnRender()
 {
+	if (IsBatchRun())
+		return;
+
 	Graphics g(GetWindow());
 
-	m_simulation->RenderAgentsVision(&g);
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
 	
 	// Clear the background.
 	g.SetViewport(m_windowViewport, true);
@@ -651,7 +750,8 @@ void SimulationApp::OnRender()
 	}
 		
 	// Draw the selected agent's brain's connectivity matrix.
-	if (m_selectedAgent != NULL && m_showBrain)
+	if (snapshot.selectedAgent.id != 0 &&
+		snapshot.selectedAgent.id == m_selectedAgentID && m_showBrain)
 	{
 		// Rendering a brain requires a non-y-flipped projection.
 		g.SetProjection(Matrix4f::CreateOrthographic(
@@ -664,7 +764,7 @@ void SimulationApp::OnRender()
 		Vector2f winCenter = Vector2f(
 			(float) GetWindow()->GetWidth(),
 			(float) GetWindow()->GetHeight()) * 0.5f;
-		m_brainRenderer->RenderBrain(&g, m_selectedAgent, winCenter);
+		m_brainRenderer->RenderBrain(&g, snapshot.selectedAgent, winCenter);
 	}
 }
 
@@ -677,63 +777,65 @@ void SimulationApp::RenderPanelWorld()
 	g.EnableDepthTest(true);
 
 	g.Clear(Color::BLACK);
+
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
 	
 	// Render the world.
-	m_simulation->GetWorldRenderer()->RenderWorld(&g, &m_camera, NULL);
+	m_simulation->GetWorldRenderer()->RenderWorld(&g, &m_camera, snapshot);
 		
 	// Draw a circle around the selected agent.
-	if (m_selectedAgent != NULL)
+	const AgentSnapshot* selectedAgent = snapshot.GetAgent(m_selectedAgentID);
+	if (selectedAgent != NULL)
 	{
 		g.ResetTransform();
-		g.Translate(m_selectedAgent->GetPosition());
-		g.Rotate(Vector3f::UNITZ, -m_selectedAgent->GetDirection());
-		g.Scale(m_selectedAgent->GetSize());
+		g.Translate(selectedAgent->position);
+		g.Rotate(Vector3f::UNITZ, -selectedAgent->direction);
+		g.Scale(selectedAgent->size);
 		g.DrawCircle(Vector2f::ZERO, m_agentSelectionRadius, Color::GREEN);
 	}
 	
 	// Draw circles around food.
 	if (m_showInteractionRadii)
 	{
-		for (auto it = m_simulation->food_begin(); it != m_simulation->food_end(); ++it)
+		for (unsigned int i = 0; i < snapshot.food.size(); i++)
 		{
-			Food* food = *it;
 			g.ResetTransform();
-			g.Translate(food->GetPosition());
-			g.DrawCircle(Vector2f::ZERO, food->GetRadius(), Color::GREEN);
+			g.Translate(snapshot.food[i].position);
+			g.DrawCircle(Vector2f::ZERO, snapshot.food[i].radius, Color::GREEN);
 		}
 	}
 
 	// Draw lines for FOV and vision.
 	if (m_showFOVLines || m_showInteractionRadii)
 	{
-		for (auto it = m_simulation->agents_begin(); it != m_simulation->agents_end(); ++it)
+		for (unsigned int i = 0; i < snapshot.agents.size(); i++)
 		{
-			Agent* agent = *it;
+			const AgentSnapshot* agent = &snapshot.agents[i];
 
 			if (m_showInteractionRadii)
 			{
 				g.ResetTransform();
-				g.Translate(agent->GetPosition());
-				g.Rotate(Vector3f::UNITZ, -agent->GetDirection());
+				g.Translate(agent->position);
+				g.Rotate(Vector3f::UNITZ, -agent->direction);
 			
-				g.DrawCircle(Vector2f::ZERO, agent->GetEatRadius(), Color::YELLOW);
-				g.DrawCircle(Vector2f::ZERO, agent->GetMateRadius(), Color::CYAN);
-				g.DrawCircle(Vector2f::ZERO, agent->GetFightRadius(), Color::RED);
+				g.DrawCircle(Vector2f::ZERO, agent->eatRadius, Color::YELLOW);
+				g.DrawCircle(Vector2f::ZERO, agent->mateRadius, Color::CYAN);
+				g.DrawCircle(Vector2f::ZERO, agent->fightRadius, Color::RED);
 			}
 
 			if (m_showFOVLines)
 			{
 				g.ResetTransform();
-				g.Translate(agent->GetPosition());
-				g.Rotate(Vector3f::UNITZ, -agent->GetDirection());
-				g.Scale(agent->GetSize());
+				g.Translate(agent->position);
+				g.Rotate(Vector3f::UNITZ, -agent->direction);
+				g.Scale(agent->size);
 				
 				// Draw FOV lines.
 				Vector3f v1(0.0f, 0.0f, 3.0f);
 				Vector3f v2(40.0f, 0.0f, 3.0f);
 				Vector3f v3(40.0f, 0.0f, 3.0f);
-				v2.Rotate(Vector3f::UNITZ, agent->GetFOV() * 0.5f);
-				v3.Rotate(Vector3f::UNITZ, -agent->GetFOV() * 0.5f);
+				v2.Rotate(Vector3f::UNITZ, agent->fov * 0.5f);
+				v3.Rotate(Vector3f::UNITZ, -agent->fov * 0.5f);
 				glBegin(GL_LINE_STRIP);
 				glColor3ub(0, 255, 255);
 				glVertex3fv(v3.data());
@@ -742,19 +844,13 @@ void SimulationApp::RenderPanelWorld()
 				glEnd();
 
 				// Draw vision strip between FOV lines.
-				int numVisionNeurons = agent->GetRetina().GetNumNeurons(0);
 				glLineWidth(3.0f);
 				glBegin(GL_LINES);
 
-				int visionWidth = 32;
+				int visionWidth = SNAPSHOT_SIGHT_SAMPLES;
 				for (int j = 0; j < visionWidth; j++)
 				{
-					Vector3f color;
-					for (int c = 0; c < agent->GetRetina().GetNumChannels(); c++)
-					{
-						int neuronIndex = (int) ((j / (float) visionWidth) * agent->GetRetina().GetNumNeurons(c));
-						color[c] = agent->GetRetina().GetSightValue(c, neuronIndex);
-					}
+					const Vector3f& color = agent->sight[j];
 				
 					Vector3f vv1 = Vector3f::Lerp(v3, v2, (float) j / (float) visionWidth);
 					Vector3f vv2 = Vector3f::Lerp(v3, v2, (float) (j + 1) / (float) visionWidth);
@@ -777,23 +873,24 @@ void SimulationApp::RenderPanelPOV()
 
 	g.Clear(Color::BLACK);
 
-	if (m_selectedAgent != NULL)
-	{
-		Agent* agent = m_selectedAgent;
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
+	const AgentSnapshot* agent = snapshot.GetAgent(m_selectedAgentID);
 
+	if (agent != NULL)
+	{
 		g.EnableCull(true);
 		g.EnableDepthTest(true);
 
 		// Render the world from the agent's POV.
 		Camera agentCam;
-		agentCam.projection = Matrix4f::CreatePerspectiveX(agent->GetFOV(),
+		agentCam.projection = Matrix4f::CreatePerspectiveX(agent->fov,
 			m_panelPOV.GetAspectRatio(), 0.1f, 1000.0f);
-		agentCam.position = Vector3f(agent->GetPosition(), 3.0f);
+		agentCam.position = Vector3f(agent->position, 3.0f);
 		agentCam.rotation = Quaternion::IDENTITY;
 		agentCam.rotation.Rotate(Vector3f::UNITZ, Math::HALF_PI);
 		agentCam.rotation.Rotate(Vector3f::UNITY, Math::HALF_PI);
-		agentCam.rotation.Rotate(Vector3f::UNITZ, agent->GetDirection());
-		m_simulation->GetWorldRenderer()->RenderWorld(&g, &agentCam, agent);
+		agentCam.rotation.Rotate(Vector3f::UNITZ, agent->direction);
+		m_simulation->GetWorldRenderer()->RenderWorld(&g, &agentCam, snapshot, agent->id);
 		
 		g.EnableCull(false);
 		g.EnableDepthTest(false);
@@ -806,23 +903,21 @@ void SimulationApp::RenderPanelPOV()
 			(float) m_panelPOV.y,
 			-1.0f, 1.0f));
 
-		// Draw the agent's 1-dimensional vision strip.
-		int numVisionNeurons = agent->GetRetina().GetNumNeurons(0);
+		// Draw the agent's 1-dimensional vision strip. It stays black until
+		// the agent's details are in the snapshot.
+		const SelectedAgentSnapshot& details = snapshot.selectedAgent;
+		bool hasDetails = (details.id == agent->id);
 		glBegin(GL_QUADS);
 
-		int visionWidth			= 32;
 		int pixelWidth			= 2;//m_panelPOV.width / 16;
 		int visionStripheight	= 24;
 		for (int x = 0; x < m_panelPOV.width; x += pixelWidth)
 		{
-			Vector3f color;
-			for (int c = 0; c < agent->GetRetina().GetNumChannels(); c++)
+			Vector3f color = Vector3f::ZERO;
+			for (int c = 0; c < 3 && hasDetails; c++)
 			{
 				float t = x / (float) m_panelPOV.width;
-				//int neuronIndex = (int) ((x / (float) m_panelPOV.width) *
-					//agent->GetRetina().GetNumNeurons(c));
-				//color[c] = agent->GetRetina().GetSightValue(c, neuronIndex);
-				color[c] = agent->GetRetina().GetInterpolatedSightValue(c, t);
+				color[c] = details.GetInterpolatedSightValue(c, t);
 			}
 			
 			glColor3fv(color.data());
@@ -866,7 +961,7 @@ void SimulationApp::RenderPanelPOV()
 		camera.projection = Matrix4f::CreateOrthographic(
 			x1, x2, y1, y2, 100.0f, -100.0f);
 
-		m_simulation->GetWorldRenderer()->RenderWorld(&g, &camera, NULL);
+		m_simulation->GetWorldRenderer()->RenderWorld(&g, &camera, snapshot);
 	}
 }
 
@@ -939,18 +1034,22 @@ void SimulationApp::RenderPanelText()
 	Vector2f textCursor		= Vector2f(10, 10);
 	char text[64];
 	
-	if (m_selectedAgent == NULL)
+	const RenderSnapshot& snapshot = m_simulationThread->GetSnapshot();
+
+	if (snapshot.selectedAgent.id == 0 || snapshot.selectedAgent.id != m_selectedAgentID)
 	{
-		SimulationStats stats = m_simulation->GetStatistics();
+		const SimulationStats& stats = snapshot.stats;
 
 		DRAW_STRING("SIMULATION");
 		DRAW_STRING("--------------------------------");
-		DRAW_STRING("age            = %d", m_simulation->GetWorldAge());
+		DRAW_STRING("age            = %d", snapshot.worldAge);
 		DRAW_STRING("size           = %.0fx%.0f", Simulation::PARAMS.worldWidth, Simulation::PARAMS.worldHeight);
+		DRAW_STRING("vision/brain   = every %d/%d ticks", Simulation::PARAMS.visionUpdateInterval,
+			Simulation::PARAMS.brainUpdateInterval);
 		DRAW_STRING("energy         = %.1f", stats.totalEnergy);
 		DRAW_STRING("energy/agent   = %.2f", stats.avgEnergy);
-		DRAW_STRING("population     = %d", (int) m_simulation->GetNumAgents());
-		DRAW_STRING("food           = %d", (int) m_simulation->GetNumFood());
+		DRAW_STRING("population     = %d / %d", snapshot.numAgents, snapshot.maxAgents);
+		DRAW_STRING("food           = %d", snapshot.numFood);
 		DRAW_STRING("");
 		DRAW_STRING("agents born    = %d", stats.numAgentsBorn);
 		DRAW_STRING("agents dead    = %d", stats.numAgentsDeadOldAge + stats.numAgentsDeadEnergy);
@@ -962,46 +1061,68 @@ void SimulationApp::RenderPanelText()
 		DRAW_STRING("  - random     = %d", stats.numAgentsCreatedRandom);
 		DRAW_STRING("births denied  = %d", stats.numBirthsDenied);
 		DRAW_STRING("");
+		DRAW_STRING("learning syn.  = %.0f%%", stats.avgLearningSynapseFraction * 100.0f);
+		DRAW_STRING("");
+		DRAW_STRING("tick           = %.2f ms", snapshot.tickTime * 1000.0);
+		for (int i = 0; i < NUM_TICK_PHASES; i++)
+		{
+			DRAW_STRING("  - %-16s= %.2f ms", TickProfiler::GetPhaseName((TickPhase) i),
+				snapshot.phaseTimes[i] * 1000.0);
+		}
+		DRAW_STRING("vision overlap = %.0f%%", m_simulationThread->GetVisionOverlap() * 100.0);
+		DRAW_STRING("vision cache   = %.0f%% (%d/%d)", m_simulation->GetVisionCache().GetHitRate() * 100.0f,
+			m_simulation->GetVisionCache().GetNumHits(),
+			m_simulation->GetVisionCache().GetNumHits() + m_simulation->GetVisionCache().GetNumMisses());
+		for (int i = 0; i < NUM_PIPELINE_STAGES; i++)
+		{
+			DRAW_STRING("  - %-16s= %.2f ms", SimulationThread::GetStageName((PipelineStage) i),
+				m_simulationThread->GetStageTime((PipelineStage) i) * 1000.0);
+		}
+		DRAW_STRING("workers        = %d", (int) m_workerUtilization.size());
+		for (unsigned int i = 0; i < m_workerUtilization.size(); i++)
+			DRAW_STRING("  - worker %-9d= %.0f%%", (int) i, m_workerUtilization[i] * 100.0f);
+		DRAW_STRING("");
 		DRAW_STRING("FPS = %.1f", GetCurrentFPS());
 	}
 	else
 	{
-		Agent* agent = m_selectedAgent;
+		const SelectedAgentSnapshot* agent = &snapshot.selectedAgent;
 		
 		char degreesSymbol = (char) 248;
 
-		DRAW_STRING("AGENT #%lu", agent->GetID());
+		DRAW_STRING("AGENT #%lu", agent->id);
 		DRAW_STRING("--------------------------------");
-		DRAW_STRING("age              = %d (%.0f%%)",	agent->GetAge(), ((float) agent->GetAge() / agent->GetGenome()->GetLifespan()) * 100.0f);
-		DRAW_STRING("energy           = %.3f (%.0f%%)",	agent->GetEnergy(), (agent->GetEnergy() / agent->GetMaxEnergy()) * 100.0f);
-		DRAW_STRING("fitness          = %.2f",			agent->GetHeuristicFitness());
+		DRAW_STRING("age              = %d (%.0f%%)",	agent->age, ((float) agent->age / agent->genomeLifespan) * 100.0f);
+		DRAW_STRING("energy           = %.3f (%.0f%%)",	agent->energy, (agent->energy / agent->maxEnergy) * 100.0f);
+		DRAW_STRING("fitness          = %.2f",			agent->fitness);
 		DRAW_STRING("");
-		DRAW_STRING("move speed       = %.2f (%.0f%%)",	agent->GetMoveSpeed(), (agent->GetMoveSpeed() / agent->GetGenome()->GetMaxSpeed()) * 100.0f);
-		DRAW_STRING("turn speed       = %.2f%c",	agent->GetTurnSpeed() * Math::RAD_TO_DEG, degreesSymbol);
-		DRAW_STRING("mate             = %.0f%%",	agent->GetMateAmount() * 100.0f);
-		DRAW_STRING("fight            = %.0f%%",	agent->GetFightAmount() * 100.0f);
-		DRAW_STRING("eat              = %.0f%%",	agent->GetEatAmount() * 100.0f);
+		DRAW_STRING("move speed       = %.2f (%.0f%%)",	agent->moveSpeed, (agent->moveSpeed / agent->maxSpeed) * 100.0f);
+		DRAW_STRING("turn speed       = %.2f%c",	agent->turnSpeed * Math::RAD_TO_DEG, degreesSymbol);
+		DRAW_STRING("mate             = %.0f%%",	agent->mateAmount * 100.0f);
+		DRAW_STRING("fight            = %.0f%%",	agent->fightAmount * 100.0f);
+		DRAW_STRING("eat              = %.0f%%",	agent->eatAmount * 100.0f);
 		DRAW_STRING("");
-		DRAW_STRING("food eaten       = %d",	agent->GetNumFoodEaten());
-		DRAW_STRING("children         = %d",	agent->GetNumChildren());
+		DRAW_STRING("food eaten       = %d",	agent->numFoodEaten);
+		DRAW_STRING("children         = %d",	agent->numChildren);
 		DRAW_STRING("");
 		DRAW_STRING("--- Genome ---------------------");
-		DRAW_STRING("size             = %.2f",		agent->GetSize());
-		DRAW_STRING("strength         = %.2f",		agent->GetStrength());
-		DRAW_STRING("fov              = %.1f%c",	agent->GetFOV() * Math::RAD_TO_DEG, degreesSymbol);
-		DRAW_STRING("max speed        = %.2f",		agent->GetGenome()->GetMaxSpeed());
-		DRAW_STRING("green color      = %d",		(int) (agent->GetGenome()->GetGreenColoration() * 255.0f));
-		DRAW_STRING("mutation rate    = %.2f%%",	agent->GetGenome()->GetMutationRate() * 100.0f);
-		DRAW_STRING("# crossover pts  = %d",		agent->GetGenome()->GetNumCrossoverPoints());
-		DRAW_STRING("lifespan         = %d",		agent->GetLifeSpan());
-		DRAW_STRING("birth energy %%   = %.0f%%",	agent->GetGenome()->GetBirthEnergyFraction() * 100.0f);
+		DRAW_STRING("size             = %.2f",		agent->size);
+		DRAW_STRING("strength         = %.2f",		agent->strength);
+		DRAW_STRING("fov              = %.1f%c",	agent->fov * Math::RAD_TO_DEG, degreesSymbol);
+		DRAW_STRING("max speed        = %.2f",		agent->maxSpeed);
+		DRAW_STRING("green color      = %d",		(int) (agent->greenColoration * 255.0f));
+		DRAW_STRING("mutation rate    = %.2f%%",	agent->mutationRate * 100.0f);
+		DRAW_STRING("# crossover pts  = %d",		agent->numCrossoverPoints);
+		DRAW_STRING("lifespan         = %d",		agent->lifespan);
+		DRAW_STRING("birth energy %%   = %.0f%%",	agent->birthEnergyFraction * 100.0f);
 		DRAW_STRING("color neurons    = %d/%d/%d",
-			agent->GetGenome()->GetNumRedNeurons(),
-			agent->GetGenome()->GetNumGreenNeurons(),
-			agent->GetGenome()->GetNumBlueNeurons());
-		DRAW_STRING("# int. groups    = %d",	agent->GetGenome()->GetNumInternalNeuralGroups());
-		DRAW_STRING("# neurons        = %d",	agent->GetBrain()->GetNeuralNet()->GetDimensions().numNeurons);
-		DRAW_STRING("# synapses       = %dl",	agent->GetBrain()->GetNeuralNet()->GetDimensions().numSynapses);
+			agent->numRedNeurons,
+			agent->numGreenNeurons,
+			agent->numBlueNeurons);
+		DRAW_STRING("# int. groups    = %d",	agent->numInternalGroups);
+		DRAW_STRING("# neurons        = %d",	agent->brainDimensions.numNeurons);
+		DRAW_STRING("# synapses       = %dl",	agent->brainDimensions.numSynapses);
+		DRAW_STRING("learning syn.    = %.0f%%",	agent->learningSynapseFraction * 100.0f);
 		DRAW_STRING("--------------------------------");
 	}
 
@@ -9,9 +9,11 @@
 #include <ArtificialLife/SimulationParams.h>
 #include <ArtificialLife/WorldRenderer.h>
 #include <ArtificialLife/ReplayRecorder.h>
+#include <ArtificialLife/MetricsRecorder.h>
 
 #include "GraphPanel.h"
 #include "BrainRenderer.h"
+#include "SimulationThread.h"
 #include <vector>
 #include <map>
 
@@ -31,12 +33,16 @@ struct GenerationInfo
 class SimulationApp : public Application
 {
 public:
-	typedef std::vector<Food> food_list;
 	typedef std::vector<Agent*> agent_list;
 
 public:
 	SimulationApp();
 	~SimulationApp();
+
+	// Run without showing anything for a number of ticks, recording metrics,
+	// then quit. Must be set before initializing.
+	void SetBatchRun(int numTicks) { m_batchTicks = numTicks; }
+	bool IsBatchRun() const { return (m_batchTicks > 0); }
 	
 protected:
 	void OnInitialize() override;
@@ -47,6 +53,7 @@ protected:
 	void UpdateControls(float timeDelta);
 	void UpdateScreenLayout();
 	void UpdateStatistics();
+	void UpdateBatchRun();
 
 	void OnRender() override;
 	void RenderPanelWorld();
@@ -62,7 +69,9 @@ private:
 	SpriteFont*		m_font;
 
 	Simulation*		m_simulation;
+	SimulationThread*	m_simulationThread;
 	ReplayRecorder*	m_replayRecorder;
+	MetricsRecorder*	m_metricsRecorder;
 	BrainRenderer*	m_brainRenderer;
 	
 	float			m_cameraFOV;
@@ -74,13 +83,17 @@ private:
 	bool			m_showBrain;
 	bool			m_followAgent;
 	Vector2f		m_cursorPos;
-	Agent*			m_selectedAgent;
 	unsigned long	m_selectedAgentID;
 
 	float			m_agentSelectionRadius;
 
-	// Statistics.
-	std::vector<float> m_recentFitnesses;
+	int				m_batchTicks;
+	double			m_batchStartTime;
+	double			m_batchReportTime;
+	int				m_batchReportAge;
+
+	// Fraction of time each job system worker was busy.
+	std::vector<float> m_workerUtilization;
 
 	// Scren layout.
 	Viewport		m_panelWorld;
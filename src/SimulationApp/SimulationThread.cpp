@@ -0,0 +1,150 @@
+#include "SimulationThread.h"
+#include <AppLib/util/Timing.h>
+
+
+SimulationThread::SimulationThread(Simulation* simulation)
+	: m_simulation(simulation)
+	, m_isTickRunning(false)
+	, m_isShuttingDown(false)
+	, m_hasNewSnapshot(false)
+	, m_isWorldCommitted(false)
+	, m_selectedAgentID(0)
+	, m_frontSnapshot(0)
+	, m_smoothing(0.05)
+	, m_lastIdleTime(0.0)
+	, m_avgVisionOverlap(0.0)
+{
+	for (int i = 0; i < NUM_PIPELINE_STAGES; i++)
+		m_avgStageTimes[i] = 0.0;
+}
+
+SimulationThread::~SimulationThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_condition.notify_all();
+
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+void SimulationThread::Start(unsigned long selectedAgentID)
+{
+	m_simulation->WriteRenderSnapshot(m_snapshots[m_frontSnapshot], selectedAgentID);
+	m_thread = std::thread(&SimulationThread::ThreadMain, this);
+}
+
+bool SimulationThread::FinishTick()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_isTickRunning)
+		return false;
+
+	if (m_hasNewSnapshot)
+	{
+		m_frontSnapshot = 1 - m_frontSnapshot;
+		m_hasNewSnapshot = false;
+		m_avgStageTimes[PIPELINE_STAGE_SIMULATION_IDLE] +=
+			(m_lastIdleTime - m_avgStageTimes[PIPELINE_STAGE_SIMULATION_IDLE]) * m_smoothing;
+	}
+	return true;
+}
+
+void SimulationThread::SubmitVision(Graphics* g)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_isTickRunning || !m_isWorldCommitted)
+			return;
+		m_isWorldCommitted = false;
+	}
+
+	// The simulation thread only touches the agents' brains and the snapshot
+	// for the rest of the tick, so the world can be drawn from this thread.
+	m_simulation->SubmitAgentsVision(g);
+}
+
+void SimulationThread::BeginTick(Graphics* g, unsigned long selectedAgentID)
+{
+	// Render the vision now if it wasn't rendered during the last tick.
+	bool overlapped = m_simulation->IsAgentsVisionSubmitted();
+	if (!overlapped)
+		m_simulation->SubmitAgentsVision(g);
+	m_simulation->ApplyAgentsVision();
+
+	const VisionTimes& times = m_simulation->GetVisionTimes();
+	double stageTimes[NUM_PIPELINE_STAGES];
+	stageTimes[PIPELINE_STAGE_VISION_SUBMIT]	= times.submitTime;
+	stageTimes[PIPELINE_STAGE_VISION_GPU]		= times.gpuTime;
+	stageTimes[PIPELINE_STAGE_VISION_WAIT]		= times.waitTime;
+	stageTimes[PIPELINE_STAGE_VISION_READ]		= times.readTime;
+	for (int i = 0; i < PIPELINE_STAGE_SIMULATION_IDLE; i++)
+		m_avgStageTimes[i] += (stageTimes[i] - m_avgStageTimes[i]) * m_smoothing;
+	m_avgVisionOverlap += ((overlapped ? 1.0 : 0.0) - m_avgVisionOverlap) * m_smoothing;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_selectedAgentID = selectedAgentID;
+		m_isTickRunning = true;
+		m_isWorldCommitted = false;
+	}
+	m_condition.notify_all();
+}
+
+const char* SimulationThread::GetStageName(PipelineStage stage)
+{
+	switch (stage)
+	{
+	case PIPELINE_STAGE_VISION_SUBMIT:		return "vision submit";
+	case PIPELINE_STAGE_VISION_GPU:			return "vision gpu";
+	case PIPELINE_STAGE_VISION_WAIT:		return "vision wait";
+	case PIPELINE_STAGE_VISION_READ:		return "vision read";
+	case PIPELINE_STAGE_SIMULATION_IDLE:	return "sim idle";
+	default:								return "unknown";
+	}
+}
+
+void SimulationThread::ThreadMain()
+{
+	// The ticks run their jobs from this thread, so it takes the place of
+	// worker 0 from the thread which initialized the simulation.
+	m_simulation->GetJobSystem()->SetMainThread();
+
+	double idleStartTime = Time::GetTime();
+
+	while (true)
+	{
+		unsigned long selectedAgentID;
+		int backSnapshot;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]()
+			{
+				return (m_isTickRunning || m_isShuttingDown);
+			});
+			if (m_isShuttingDown)
+				return;
+			selectedAgentID = m_selectedAgentID;
+			backSnapshot = 1 - m_frontSnapshot;
+			m_lastIdleTime = Time::GetTime() - idleStartTime;
+		}
+
+		m_simulation->UpdateWorld();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isWorldCommitted = true;
+		}
+
+		m_simulation->FinishUpdate();
+		m_simulation->WriteRenderSnapshot(m_snapshots[backSnapshot], selectedAgentID);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_hasNewSnapshot = true;
+			m_isTickRunning = false;
+		}
+		idleStartTime = Time::GetTime();
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef _SIMULATION_THREAD_H_
+#define _SIMULATION_THREAD_H_
+
+#include <ArtificialLife/Simulation.h>
+#include <ArtificialLife/RenderSnapshot.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// The stages of the tick pipeline which are timed.
+enum PipelineStage
+{
+	PIPELINE_STAGE_VISION_SUBMIT = 0,	// UI thread issuing the vision draws and readback.
+	PIPELINE_STAGE_VISION_GPU,			// GPU rendering the vision.
+	PIPELINE_STAGE_VISION_WAIT,			// UI thread blocked waiting for the readback.
+	PIPELINE_STAGE_VISION_READ,			// UI thread passing the pixels to the agents.
+	PIPELINE_STAGE_SIMULATION_IDLE,		// Simulation thread waiting for its next tick.
+
+	NUM_PIPELINE_STAGES,
+};
+
+
+//-----------------------------------------------------------------------------
+// SimulationThread - runs the simulation's ticks on their own thread, so the
+// UI can be drawn at the same time. At the end of each tick, the simulation
+// writes a render snapshot into the back buffer. Once the UI thread has seen
+// that the tick is done, the snapshots are swapped, and the UI draws from the
+// front snapshot while the next tick writes into the back one.
+//
+// Agent vision needs the OpenGL context, which belongs to the UI thread. Once
+// a tick has committed the world (see Simulation::UpdateWorld), the UI thread
+// submits the next tick's vision, so the GPU renders it while the simulation
+// finishes the tick. The UI thread only waits for the pixels when the next
+// tick begins.
+//-----------------------------------------------------------------------------
+class SimulationThread
+{
+public:
+	SimulationThread(Simulation* simulation);
+	~SimulationThread();
+
+	// Take the first snapshot and start the thread.
+	void Start(unsigned long selectedAgentID);
+
+	// Returns true if no tick is running. Then the simulation can be used on
+	// the calling thread until the next tick begins, and the front snapshot
+	// is the one from the last tick.
+	bool FinishTick();
+
+	// Submit the next tick's vision if the running tick has committed the
+	// world. Call this every frame.
+	void SubmitVision(Graphics* g);
+
+	// Pass the vision to the agents and start a tick on the simulation
+	// thread. The selected agent's details will be put into the tick's
+	// snapshot.
+	void BeginTick(Graphics* g, unsigned long selectedAgentID);
+
+	// Times are in seconds per tick, averaged over recent ticks.
+	double GetStageTime(PipelineStage stage) const { return m_avgStageTimes[stage]; }
+
+	// The fraction of recent ticks whose vision was rendered during the
+	// previous tick.
+	double GetVisionOverlap() const { return m_avgVisionOverlap; }
+
+	static const char* GetStageName(PipelineStage stage);
+
+	const RenderSnapshot& GetSnapshot() const { return m_snapshots[m_frontSnapshot]; }
+
+private:
+	void ThreadMain();
+
+	Simulation*				m_simulation;
+	std::thread				m_thread;
+	std::mutex				m_mutex;
+	std::condition_variable	m_condition;
+	bool					m_isTickRunning;
+	bool					m_isShuttingDown;
+	bool					m_hasNewSnapshot;
+	bool					m_isWorldCommitted;
+	unsigned long			m_selectedAgentID;
+
+	RenderSnapshot			m_snapshots[2];
+	int						m_frontSnapshot;
+
+	double					m_smoothing; // Weight of the newest tick in the rolling averages.
+	double					m_lastIdleTime;
+	double					m_avgStageTimes[NUM_PIPELINE_STAGES];
+	double					m_avgVisionOverlap;
+};
+
+
+#endif // _SIMULATION_THREAD_H_
@@ -0,0 +1,132 @@
+#include "TimeSeries.h"
+
+
+//-----------------------------------------------------------------------------
+// TimeSeriesBucket
+//-----------------------------------------------------------------------------
+
+void TimeSeriesBucket::Add(float value)
+{
+	if (count == 0 || value < min)
+		min = value;
+	if (count == 0 || value > max)
+		max = value;
+	sum += value;
+	count++;
+}
+
+void TimeSeriesBucket::Merge(const TimeSeriesBucket& other)
+{
+	if (other.count == 0)
+		return;
+	if (count == 0 || other.min < min)
+		min = other.min;
+	if (count == 0 || other.max > max)
+		max = other.max;
+	sum += other.sum;
+	count += other.count;
+}
+
+
+//-----------------------------------------------------------------------------
+// TimeSeries
+//-----------------------------------------------------------------------------
+
+TimeSeries::TimeSeries(int bucketCapacity, int numLevels)
+	: m_count(0)
+	, m_bucketCapacity(bucketCapacity + (bucketCapacity % 2)) // Even, so the top level can merge pairs.
+	, m_levels(numLevels)
+{
+	int bucketSize = 1;
+	for (int i = 0; i < numLevels; i++)
+	{
+		Level& level = m_levels[i];
+		level.bucketSize	= bucketSize;
+		level.start			= 0;
+		level.numBuckets	= 0;
+		level.firstSample	= 0;
+		level.buckets.resize(m_bucketCapacity);
+		bucketSize *= 4;
+	}
+}
+
+void TimeSeries::Add(float value)
+{
+	int topLevel = (int) m_levels.size() - 1;
+
+	for (int i = 0; i <= topLevel; i++)
+	{
+		Level& level = m_levels[i];
+		level.partial.Add(value);
+		if (level.partial.count < level.bucketSize)
+			continue;
+
+		if (i == topLevel && level.numBuckets == m_bucketCapacity)
+		{
+			// The top level never forgets, so make room by doubling its bucket
+			// size. The partial bucket is now only half full.
+			Compact(level);
+		}
+		else if (level.numBuckets < m_bucketCapacity)
+		{
+			level.buckets[(level.start + level.numBuckets) % m_bucketCapacity] = level.partial;
+			level.numBuckets++;
+			level.partial = TimeSeriesBucket();
+		}
+		else
+		{
+			// Overwrite the oldest bucket.
+			level.buckets[level.start] = level.partial;
+			level.start = (level.start + 1) % m_bucketCapacity;
+			level.firstSample += level.bucketSize;
+			level.partial = TimeSeriesBucket();
+		}
+	}
+
+	m_count++;
+}
+
+int TimeSeries::PickLevel(int maxBuckets) const
+{
+	for (unsigned int i = 0; i < m_levels.size(); i++)
+	{
+		if (m_levels[i].firstSample == 0 && GetBucketCount(i) <= maxBuckets)
+			return (int) i;
+	}
+	return (int) m_levels.size() - 1;
+}
+
+int TimeSeries::GetBucketCount(int level) const
+{
+	const Level& lvl = m_levels[level];
+	return lvl.numBuckets + (lvl.partial.count > 0 ? 1 : 0);
+}
+
+const TimeSeriesBucket& TimeSeries::GetBucket(int level, int index) const
+{
+	const Level& lvl = m_levels[level];
+	if (index >= lvl.numBuckets)
+		return lvl.partial;
+	return lvl.buckets[(lvl.start + index) % m_bucketCapacity];
+}
+
+int TimeSeries::GetBucketStart(int level, int index) const
+{
+	const Level& lvl = m_levels[level];
+	return lvl.firstSample + (index * lvl.bucketSize);
+}
+
+// Merge pairs of buckets in a full level (which must not have wrapped around
+// its ring), doubling the bucket size.
+void TimeSeries::Compact(Level& level)
+{
+	int half = level.numBuckets / 2;
+	for (int i = 0; i < half; i++)
+	{
+		TimeSeriesBucket bucket = level.buckets[i * 2];
+		bucket.Merge(level.buckets[(i * 2) + 1]);
+		level.buckets[i] = bucket;
+	}
+	level.numBuckets = half;
+	level.bucketSize *= 2;
+}
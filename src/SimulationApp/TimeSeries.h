@@ -0,0 +1,79 @@
+#ifndef _TIME_SERIES_H_
+#define _TIME_SERIES_H_
+
+#include <vector>
+
+
+// The minimum, maximum and sum of a run of consecutive samples.
+struct TimeSeriesBucket
+{
+	float	min;
+	float	max;
+	float	sum;
+	int		count;
+
+	TimeSeriesBucket()
+		: min(0.0f)
+		, max(0.0f)
+		, sum(0.0f)
+		, count(0)
+	{}
+
+	float GetMean() const { return (count > 0 ? sum / count : 0.0f); }
+
+	void Add(float value);
+	void Merge(const TimeSeriesBucket& other);
+};
+
+
+//-----------------------------------------------------------------------------
+// TimeSeries - a bounded history of samples kept at several levels of detail.
+// Each level groups the samples into buckets, with four times as many samples
+// per bucket as the level below it. The lower levels only remember their most
+// recent buckets, while the top level covers the whole history and merges
+// its buckets in pairs whenever it fills up. Adding a sample takes constant
+// time and memory never grows past a fixed number of buckets per level.
+//-----------------------------------------------------------------------------
+class TimeSeries
+{
+public:
+	TimeSeries(int bucketCapacity = 1024, int numLevels = 8);
+
+	void Add(float value);
+
+	int GetCount()		const { return m_count; }
+	int GetNumLevels()	const { return (int) m_levels.size(); }
+
+	// Pick the most detailed level that covers the whole history using no
+	// more than the given number of buckets (e.g. the width of a graph in
+	// pixels). Falls back to the top level.
+	int PickLevel(int maxBuckets) const;
+
+	// The number of buckets at a level, including the partially filled one
+	// at the end.
+	int GetBucketCount(int level) const;
+	const TimeSeriesBucket& GetBucket(int level, int index) const;
+
+	// The index of the first sample in a bucket.
+	int GetBucketStart(int level, int index) const;
+
+private:
+	struct Level
+	{
+		int								bucketSize;		// Number of samples in each bucket.
+		int								start;			// Index of the oldest bucket in the ring.
+		int								numBuckets;
+		int								firstSample;	// Index of the first sample in the oldest bucket.
+		std::vector<TimeSeriesBucket>	buckets;
+		TimeSeriesBucket				partial;		// Bucket currently being filled.
+	};
+
+	void Compact(Level& level);
+
+	int					m_count;
+	int					m_bucketCapacity;
+	std::vector<Level>	m_levels;
+};
+
+
+#endif // _TIME_SERIES_H_
@@ -7,6 +7,8 @@
 #include "ArtificialLife/genome/BrainGenome.h"
 #include <AppLib/math/MathLib.h>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
 
@@ -56,6 +58,18 @@ void PrintGenome(const char* genomeName, BrainGenome* genome)
 	}
 }
 
+void PrintUsage(const char* program)
+{
+	cout << "Usage: " << program << " [--batch <ticks>] [--benchmark-spatial-sort <sites> <agents>]" << endl;
+	cout << "  --batch <ticks>     Run <ticks> ticks in a hidden window, recording metrics," << endl;
+	cout << "                      then exit. The vision is still rendered with OpenGL in" << endl;
+	cout << "                      a window, so this needs a display. Without one, run" << endl;
+	cout << "                      under a virtual display such as Xvfb (xvfb-run)." << endl;
+	cout << "  --benchmark-spatial-sort <sites> <agents>" << endl;
+	cout << "                      Time the eat query and agent lookups with and without" << endl;
+	cout << "                      Morton order, then exit." << endl;
+}
+
 int main(int argc, char** argv)
 {
 	Random::SeedTime();
@@ -172,9 +186,45 @@ int main(int argc, char** argv)
 	int width  = 1100;
 	int height = 800;
 
+	// The options are described in PrintUsage().
+	int batchTicks = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--benchmark-spatial-sort") == 0)
+		{
+			if (i + 2 >= argc)
+			{
+				PrintUsage(argv[0]);
+				return 1;
+			}
+			Simulation::ReportSpatialSortBenchmark(atoi(argv[i + 1]), atoi(argv[i + 2]));
+			return 0;
+		}
+		else if (strcmp(argv[i], "--batch") == 0)
+		{
+			if (i + 1 < argc)
+				batchTicks = atoi(argv[++i]);
+			if (batchTicks <= 0)
+			{
+				PrintUsage(argv[0]);
+				return 1;
+			}
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
 	SimulationApp application;
-	if (!application.Initialize(title, width, height))
+	application.SetBatchRun(batchTicks);
+	if (!application.Initialize(title, width, height, application.IsBatchRun()))
+	{
+		if (application.IsBatchRun())
+			cout << "Couldn't create the hidden window. See --batch in the usage." << endl;
 		return 1;
+	}
 
 	application.Run();
 